@@ -0,0 +1,381 @@
+/**
+ * Copyright (C) 2023 Masatoshi Fukunaga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+#include "lmdbx.h"
+#include <math.h>
+
+// aggregate the numbers at the fixed offset of the values in the range.
+// the values of a DUPFIXED database are fetched a page at a time by
+// MDBX_GET_MULTIPLE, and each page is reduced by the unrolled kernels that
+// can be vectorized by the compiler.
+
+enum {
+    AGG_SUM = 0,
+    AGG_MIN,
+    AGG_MAX,
+    AGG_COUNT,
+};
+
+typedef struct agg_s agg_t;
+typedef void (*agg_kernel_t)(agg_t *a, const char *p, size_t n,
+                             size_t stride);
+
+struct agg_s {
+    int op;
+    lmdbx_field_t field;
+    agg_kernel_t kernel;
+    uint64_t n;
+    // the sum of integers is accumulated in u64 and wraps around
+    union {
+        int64_t i64;
+        uint64_t u64;
+        double f64;
+    } acc;
+};
+
+#define DEFINE_SUM(S, T, ACC_T, M)                                             \
+    static void sum_##S(agg_t *a, const char *p, size_t n, size_t stride)     \
+    {                                                                          \
+        ACC_T s[4] = {0};                                                      \
+        size_t i   = 0;                                                        \
+        T x        = 0;                                                        \
+                                                                               \
+        for (; i + 4 <= n; i += 4) {                                           \
+            for (int j = 0; j < 4; j++) {                                      \
+                memcpy(&x, p + (i + j) * stride, sizeof(T));                   \
+                s[j] += (ACC_T)x;                                              \
+            }                                                                  \
+        }                                                                      \
+        for (; i < n; i++) {                                                   \
+            memcpy(&x, p + i * stride, sizeof(T));                             \
+            s[0] += (ACC_T)x;                                                  \
+        }                                                                      \
+        a->acc.M += s[0] + s[1] + s[2] + s[3];                                 \
+    }
+
+#define DEFINE_CMP(NAME, S, T, CMP_T, M, OP)                                   \
+    static void NAME##_##S(agg_t *a, const char *p, size_t n, size_t stride)  \
+    {                                                                          \
+        CMP_T m[4] = {a->acc.M, a->acc.M, a->acc.M, a->acc.M};                 \
+        size_t i   = 0;                                                        \
+        T x        = 0;                                                        \
+                                                                               \
+        for (; i + 4 <= n; i += 4) {                                           \
+            for (int j = 0; j < 4; j++) {                                      \
+                memcpy(&x, p + (i + j) * stride, sizeof(T));                   \
+                if ((CMP_T)x OP m[j]) {                                        \
+                    m[j] = x;                                                  \
+                }                                                              \
+            }                                                                  \
+        }                                                                      \
+        for (; i < n; i++) {                                                   \
+            memcpy(&x, p + i * stride, sizeof(T));                             \
+            if ((CMP_T)x OP m[0]) {                                            \
+                m[0] = x;                                                      \
+            }                                                                  \
+        }                                                                      \
+        for (int j = 0; j < 4; j++) {                                          \
+            if (m[j] OP a->acc.M) {                                            \
+                a->acc.M = m[j];                                               \
+            }                                                                  \
+        }                                                                      \
+    }
+
+#define DEFINE_KERNELS(S, T, SUM_T, SUM_M, CMP_T, CMP_M)                       \
+    DEFINE_SUM(S, T, SUM_T, SUM_M)                                             \
+    DEFINE_CMP(min, S, T, CMP_T, CMP_M, <)                                     \
+    DEFINE_CMP(max, S, T, CMP_T, CMP_M, >)
+
+DEFINE_KERNELS(i8, int8_t, uint64_t, u64, int64_t, i64)
+DEFINE_KERNELS(i16, int16_t, uint64_t, u64, int64_t, i64)
+DEFINE_KERNELS(i32, int32_t, uint64_t, u64, int64_t, i64)
+DEFINE_KERNELS(i64, int64_t, uint64_t, u64, int64_t, i64)
+DEFINE_KERNELS(u8, uint8_t, uint64_t, u64, uint64_t, u64)
+DEFINE_KERNELS(u16, uint16_t, uint64_t, u64, uint64_t, u64)
+DEFINE_KERNELS(u32, uint32_t, uint64_t, u64, uint64_t, u64)
+DEFINE_KERNELS(u64, uint64_t, uint64_t, u64, uint64_t, u64)
+DEFINE_KERNELS(f32, float, double, f64, double, f64)
+DEFINE_KERNELS(f64, double, double, f64, double, f64)
+
+static const struct {
+    int type;
+    size_t width;
+    agg_kernel_t kernels[3];
+} KERNELS[] = {
+    {LMDBX_FIELD_INT,   1, {sum_i8, min_i8, max_i8}   },
+    {LMDBX_FIELD_INT,   2, {sum_i16, min_i16, max_i16}},
+    {LMDBX_FIELD_INT,   4, {sum_i32, min_i32, max_i32}},
+    {LMDBX_FIELD_INT,   8, {sum_i64, min_i64, max_i64}},
+    {LMDBX_FIELD_UINT,  1, {sum_u8, min_u8, max_u8}   },
+    {LMDBX_FIELD_UINT,  2, {sum_u16, min_u16, max_u16}},
+    {LMDBX_FIELD_UINT,  4, {sum_u32, min_u32, max_u32}},
+    {LMDBX_FIELD_UINT,  8, {sum_u64, min_u64, max_u64}},
+    {LMDBX_FIELD_FLOAT, 4, {sum_f32, min_f32, max_f32}},
+    {LMDBX_FIELD_FLOAT, 8, {sum_f64, min_f64, max_f64}},
+};
+
+static void init_agg(agg_t *a)
+{
+    for (size_t i = 0; i < sizeof(KERNELS) / sizeof(KERNELS[0]); i++) {
+        if (KERNELS[i].type == a->field.type &&
+            KERNELS[i].width == a->field.width) {
+            a->kernel = KERNELS[i].kernels[a->op];
+            break;
+        }
+    }
+
+    // the initial value of min and max is the identity of the operation
+    switch (a->field.type) {
+    case LMDBX_FIELD_INT:
+        if (a->op != AGG_SUM) {
+            a->acc.i64 = (a->op == AGG_MIN) ? INT64_MAX : INT64_MIN;
+        }
+        break;
+    case LMDBX_FIELD_UINT:
+        if (a->op == AGG_MIN) {
+            a->acc.u64 = UINT64_MAX;
+        }
+        break;
+    default:
+        if (a->op != AGG_SUM) {
+            a->acc.f64 = (a->op == AGG_MIN) ? HUGE_VAL : -HUGE_VAL;
+        }
+    }
+}
+
+static void check_agg(lua_State *L, int idx, agg_t *a)
+{
+    static const char *const ops[] = {
+        [AGG_SUM] = "sum", [AGG_MIN] = "min", [AGG_MAX] = "max",
+        [AGG_COUNT] = "count", NULL,
+    };
+    lua_Integer offset = 0;
+
+    a->op = AGG_COUNT;
+    if (lua_isnoneornil(L, idx)) {
+        return;
+    }
+    luaL_checktype(L, idx, LUA_TTABLE);
+
+    lua_getfield(L, idx, "op");
+    if (!lua_isnil(L, -1)) {
+        const char *op = lua_tostring(L, -1);
+
+        for (a->op = 0; op && ops[a->op]; a->op++) {
+            if (strcmp(op, ops[a->op]) == 0) {
+                break;
+            }
+        }
+        if (!op || !ops[a->op]) {
+            lauxh_argerror(L, idx, "field 'op' must be count, sum, min or "
+                                   "max");
+        }
+    }
+    lua_pop(L, 1);
+    if (a->op == AGG_COUNT) {
+        return;
+    }
+
+    // the number is specified by the field of the schema, or by the type
+    // and the offset
+    lua_getfield(L, idx, "schema");
+    if (!lua_isnil(L, -1)) {
+        lmdbx_schema_t *s = lauxh_checkudata(L, -1, LMDBX_SCHEMA_MT);
+        int top           = lua_gettop(L);
+
+        lua_getfield(L, idx, "field");
+        a->field = *lmdbx_schema_checkfield(L, s, top + 1);
+        lua_pop(L, 2);
+    } else {
+        lua_pop(L, 1);
+        lua_getfield(L, idx, "type");
+        if (lua_type(L, -1) != LUA_TSTRING ||
+            lmdbx_schema_parsetype(lua_tostring(L, -1), &a->field)) {
+            lauxh_argerror(L, idx, "field 'type' must be valid type string");
+        }
+        lua_pop(L, 1);
+        offset = lmdbx_optintfield(L, idx, "offset", 0);
+        if (offset < 0) {
+            lauxh_argerror(L, idx, "field 'offset' must be greater than or "
+                                   "equal to 0");
+        }
+        a->field.offset = offset;
+    }
+    if (a->field.type != LMDBX_FIELD_INT && a->field.type != LMDBX_FIELD_UINT &&
+        a->field.type != LMDBX_FIELD_FLOAT) {
+        lauxh_argerror(L, idx, "field type must be integer or floating point "
+                               "type");
+    }
+    init_agg(a);
+}
+
+// reduce n values that are placed at the interval of stride.
+static inline int reduce(agg_t *a, const MDBX_val *v, size_t n,
+                         size_t stride)
+{
+    if (stride < a->field.offset + a->field.width) {
+        return MDBX_BAD_VALSIZE;
+    }
+    a->kernel(a, (const char *)v->iov_base + a->field.offset, n, stride);
+    a->n += n;
+    return MDBX_SUCCESS;
+}
+
+// reduce all values of the current key of the DUPFIXED database a page at a
+// time, and the cursor is moved to the last value of the key.
+static int reduce_multiple(agg_t *a, MDBX_cursor *cur, MDBX_val *k,
+                           size_t stride)
+{
+    MDBX_val v = {0};
+    int rc     = mdbx_cursor_get(cur, k, &v, MDBX_GET_MULTIPLE);
+
+    while (rc == MDBX_SUCCESS) {
+        if ((rc = reduce(a, &v, v.iov_len / stride, stride))) {
+            return rc;
+        }
+        rc = mdbx_cursor_get(cur, k, &v, MDBX_NEXT_MULTIPLE);
+    }
+    return (rc == MDBX_NOTFOUND) ? MDBX_SUCCESS : rc;
+}
+
+static int reduce_value(lua_State *L, agg_t *a, lmdbx_cursor_t *cur,
+                        MDBX_val *v)
+{
+    MDBX_val dv = *v;
+    int rc      = 0;
+
+    if (!cur->compress.enabled) {
+        return reduce(a, v, 1, v->iov_len);
+    } else if ((rc = lmdbx_compress_decode(L, &dv)) == MDBX_SUCCESS) {
+        rc = reduce(a, &dv, 1, dv.iov_len);
+    }
+    lua_pop(L, 1);
+    return rc;
+}
+
+static int aggregate(lua_State *L, agg_t *a, lmdbx_cursor_t *cur,
+                     MDBX_val *start, MDBX_val *stop, int start_inclusive,
+                     int stop_inclusive)
+{
+    MDBX_txn *txn = mdbx_cursor_txn(cur->cur);
+    MDBX_dbi dbi  = mdbx_cursor_dbi(cur->cur);
+    int dupsort   = (cur->flags & MDBX_DUPSORT) != 0;
+    int dupfixed  = (cur->flags & MDBX_DUPFIXED) != 0;
+    MDBX_val k    = {0};
+    MDBX_val v    = {0};
+    int rc        = 0;
+
+    if (!start) {
+        rc = mdbx_cursor_get(cur->cur, &k, &v, MDBX_FIRST);
+    } else {
+        k  = *start;
+        rc = mdbx_cursor_get(cur->cur, &k, &v, MDBX_SET_RANGE);
+        if (rc == MDBX_SUCCESS && !start_inclusive &&
+            mdbx_cmp(txn, dbi, &k, start) == 0) {
+            rc = mdbx_cursor_get(cur->cur, &k, &v, MDBX_NEXT_NODUP);
+        }
+    }
+
+    while (rc == MDBX_SUCCESS) {
+        MDBX_cursor_op op = MDBX_NEXT;
+
+        if (stop) {
+            int cmp = mdbx_cmp(txn, dbi, &k, stop);
+            if (cmp > 0 || (cmp == 0 && !stop_inclusive)) {
+                break;
+            }
+        }
+
+        if (a->op == AGG_COUNT) {
+            size_t n = 1;
+            if (dupsort && (rc = mdbx_cursor_count(cur->cur, &n))) {
+                return rc;
+            }
+            a->n += n;
+            op = MDBX_NEXT_NODUP;
+        } else if (dupfixed) {
+            // the cursor is on the first value of the key
+            if ((rc = reduce_multiple(a, cur->cur, &k, v.iov_len))) {
+                return rc;
+            }
+            op = MDBX_NEXT_NODUP;
+        } else if ((rc = reduce_value(L, a, cur, &v))) {
+            return rc;
+        }
+        rc = mdbx_cursor_get(cur->cur, &k, &v, op);
+    }
+
+    return (rc == MDBX_NOTFOUND) ? MDBX_SUCCESS : rc;
+}
+
+int lmdbx_cursor_aggregate_lua(lua_State *L)
+{
+    lmdbx_cursor_t *cur = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
+    agg_t a             = {0};
+    MDBX_val bounds[2]  = {0};
+    int start_inclusive = 1;
+    int stop_inclusive  = 0;
+    int rc              = 0;
+
+    // cur:aggregate([start [, stop [, opts]]])
+    // opts.op is one of count (default), sum, min and max. the number to be
+    // aggregated is specified by opts.type and opts.offset, or by
+    // opts.schema and opts.field. returns the result and the number of the
+    // aggregated values.
+    check_agg(L, 4, &a);
+    if (lua_istable(L, 4)) {
+        start_inclusive = lmdbx_optboolfield(L, 4, "start_inclusive", 1);
+        stop_inclusive  = lmdbx_optboolfield(L, 4, "stop_inclusive", 0);
+    }
+    lua_settop(L, 3);
+    for (int i = 0; i < 2; i++) {
+        lmdbx_topacked(L, i + 2, LMDBX_INTKEY(cur));
+        if (!lua_isnil(L, i + 2)) {
+            bounds[i].iov_base =
+                (void *)lauxh_checklstring(L, i + 2, &bounds[i].iov_len);
+        }
+    }
+
+    rc = aggregate(L, &a, cur, (lua_isnil(L, 2)) ? NULL : &bounds[0],
+                   (lua_isnil(L, 3)) ? NULL : &bounds[1], start_inclusive,
+                   stop_inclusive);
+    if (rc) {
+        lua_pushnil(L);
+        lmdbx_pusherror(L, rc);
+        return 2;
+    }
+
+    if (a.op == AGG_COUNT) {
+        lua_pushinteger(L, a.n);
+    } else if (a.op != AGG_SUM && a.n == 0) {
+        // no values to compare
+        lua_pushnil(L);
+    } else if (a.field.type == LMDBX_FIELD_FLOAT) {
+        lua_pushnumber(L, a.acc.f64);
+    } else if (a.field.type == LMDBX_FIELD_INT && a.op != AGG_SUM) {
+        lua_pushinteger(L, a.acc.i64);
+    } else {
+        lua_pushinteger(L, (lua_Integer)a.acc.u64);
+    }
+    lua_pushinteger(L, a.n);
+    return 2;
+}
@@ -0,0 +1,145 @@
+/**
+ * Copyright (C) 2023 Masatoshi Fukunaga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+#include "lmdbx.h"
+
+// built-in comparators that can be specified to txn:dbi_open.
+// the same comparator must be used every time the database is opened.
+
+static inline int cmp_len(size_t a, size_t b)
+{
+    return (a > b) - (a < b);
+}
+
+// compare the lengths first, then the bytes
+static int cmp_lenbytes(const MDBX_val *a, const MDBX_val *b)
+{
+    int rv = cmp_len(a->iov_len, b->iov_len);
+
+    if (rv == 0 && a->iov_len) {
+        rv = memcmp(a->iov_base, b->iov_base, a->iov_len);
+    }
+    return rv;
+}
+
+// compare as signed 64-bit integers in native byte order
+static int cmp_int64(const MDBX_val *a, const MDBX_val *b)
+{
+    int64_t x = 0;
+    int64_t y = 0;
+
+    if (a->iov_len != sizeof(int64_t) || b->iov_len != sizeof(int64_t)) {
+        return cmp_lenbytes(a, b);
+    }
+    memcpy(&x, a->iov_base, sizeof(x));
+    memcpy(&y, b->iov_base, sizeof(y));
+    return (x > y) - (x < y);
+}
+
+// map the bits of the double to the unsigned integer in the total order:
+// -NaN < -Inf < ... < -0 < +0 < ... < +Inf < +NaN
+#define DOUBLE_SIGN UINT64_C(0x8000000000000000)
+
+static inline uint64_t double_order(const void *p)
+{
+    uint64_t u = 0;
+
+    memcpy(&u, p, sizeof(u));
+    return (u & DOUBLE_SIGN) ? ~u : u | DOUBLE_SIGN;
+}
+
+// compare as IEEE 754 doubles in native byte order. the comparison of the
+// double values is not a strict weak ordering for NaN, so that the bits are
+// compared in the total order instead.
+static int cmp_double(const MDBX_val *a, const MDBX_val *b)
+{
+    uint64_t x = 0;
+    uint64_t y = 0;
+
+    if (a->iov_len != sizeof(double) || b->iov_len != sizeof(double)) {
+        return cmp_lenbytes(a, b);
+    }
+    x = double_order(a->iov_base);
+    y = double_order(b->iov_base);
+    return (x > y) - (x < y);
+}
+
+// tolower() depends on the locale, and the order of the keys must not change
+static inline int ascii_tolower(int c)
+{
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+// compare ASCII letters case-insensitively, then the lengths
+static int cmp_icase(const MDBX_val *a, const MDBX_val *b)
+{
+    const unsigned char *x = a->iov_base;
+    const unsigned char *y = b->iov_base;
+    size_t len = (a->iov_len < b->iov_len) ? a->iov_len : b->iov_len;
+
+    for (size_t i = 0; i < len; i++) {
+        int rv = ascii_tolower(x[i]) - ascii_tolower(y[i]);
+        if (rv) {
+            return rv;
+        }
+    }
+    return cmp_len(a->iov_len, b->iov_len);
+}
+
+// reverse of the default lexicographic order
+static int cmp_reverse(const MDBX_val *a, const MDBX_val *b)
+{
+    size_t len = (a->iov_len < b->iov_len) ? a->iov_len : b->iov_len;
+    int rv     = (len) ? memcmp(a->iov_base, b->iov_base, len) : 0;
+
+    if (rv == 0) {
+        rv = cmp_len(a->iov_len, b->iov_len);
+    }
+    return -rv;
+}
+
+static const struct {
+    const char *name;
+    MDBX_cmp_func *func;
+} COMPARATORS[] = {
+    {"int64",    cmp_int64   },
+    {"double",   cmp_double  },
+    {"lenbytes", cmp_lenbytes},
+    {"icase",    cmp_icase   },
+    {"reverse",  cmp_reverse },
+    {NULL,       NULL        }
+};
+
+MDBX_cmp_func *lmdbx_cmp_find(const char *name)
+{
+    for (int i = 0; COMPARATORS[i].name; i++) {
+        if (strcmp(COMPARATORS[i].name, name) == 0) {
+            return COMPARATORS[i].func;
+        }
+    }
+    return NULL;
+}
+
+int lmdbx_cmp_isint(MDBX_cmp_func *cmp)
+{
+    return cmp == cmp_int64;
+}
@@ -0,0 +1,309 @@
+/**
+ * Copyright (C) 2023 Masatoshi Fukunaga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+#include "lmdbx.h"
+
+// values of the database that enables the compression have a header byte.
+//
+//  0x00 <value>                              : stored as is
+//  0x01 <4 bytes LE original length> <block> : compressed in the LZ4 block
+//                                              format
+#define HDR_RAW     LMDBX_COMPRESS_RAW
+#define HDR_LZ4     0x01
+#define HDR_LZ4_LEN 5
+
+#define LZ4_MINMATCH 4
+// the last match must start at least 12 bytes before the end of the block,
+// and the last 5 bytes are always literals
+#define LZ4_MFLIMIT   12
+#define LZ4_LASTLITS  5
+#define LZ4_HASHLOG   12
+#define LZ4_MAXOFFSET 65535
+
+static inline uint32_t read32(const uint8_t *p)
+{
+    uint32_t v = 0;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t hash4(uint32_t v)
+{
+    return (v * 2654435761U) >> (32 - LZ4_HASHLOG);
+}
+
+static inline uint8_t *put_length(uint8_t *op, size_t len)
+{
+    for (; len >= 255; len -= 255) {
+        *op++ = 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+// returns the size of the compressed block, or 0 if it does not fit in cap.
+static size_t lz4_compress(const uint8_t *src, size_t len, uint8_t *dst,
+                           size_t cap)
+{
+    uint32_t table[1 << LZ4_HASHLOG] = {0};
+    const uint8_t *ip                = src;
+    const uint8_t *anchor            = src;
+    const uint8_t *end               = src + len;
+    uint8_t *op                      = dst;
+    uint8_t *oend                    = dst + cap;
+    size_t litlen                    = 0;
+
+    if (len > LZ4_MFLIMIT) {
+        const uint8_t *mflimit    = end - LZ4_MFLIMIT;
+        const uint8_t *matchlimit = end - LZ4_LASTLITS;
+
+        for (ip++; ip < mflimit;) {
+            uint32_t seq       = read32(ip);
+            uint32_t h         = hash4(seq);
+            const uint8_t *ref = src + table[h];
+            const uint8_t *mp  = NULL;
+            uint8_t *token     = NULL;
+            size_t mlen        = 0;
+
+            table[h] = (uint32_t)(ip - src);
+            if (ref >= ip || ip - ref > LZ4_MAXOFFSET || read32(ref) != seq) {
+                ip++;
+                continue;
+            }
+            // extend the match backwards and forwards
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            mp = ip + LZ4_MINMATCH;
+            for (const uint8_t *rp = ref + LZ4_MINMATCH;
+                 mp < matchlimit && *mp == *rp; rp++) {
+                mp++;
+            }
+
+            litlen = ip - anchor;
+            mlen   = mp - ip - LZ4_MINMATCH;
+            if ((size_t)(oend - op) <
+                1 + litlen / 255 + 1 + litlen + 2 + mlen / 255 + 1) {
+                return 0;
+            }
+            // token, literals, offset and match length
+            token = op++;
+            if (litlen >= 15) {
+                *token = 15 << 4;
+                op     = put_length(op, litlen - 15);
+            } else {
+                *token = (uint8_t)(litlen << 4);
+            }
+            memcpy(op, anchor, litlen);
+            op += litlen;
+            *op++ = (uint8_t)(ip - ref);
+            *op++ = (uint8_t)((ip - ref) >> 8);
+            if (mlen >= 15) {
+                *token |= 15;
+                op = put_length(op, mlen - 15);
+            } else {
+                *token |= (uint8_t)mlen;
+            }
+            ip = anchor = mp;
+        }
+    }
+
+    // last literals
+    litlen = end - anchor;
+    if ((size_t)(oend - op) < 1 + litlen / 255 + 1 + litlen) {
+        return 0;
+    }
+    if (litlen >= 15) {
+        *op++ = 15 << 4;
+        op    = put_length(op, litlen - 15);
+    } else {
+        *op++ = (uint8_t)(litlen << 4);
+    }
+    memcpy(op, anchor, litlen);
+    op += litlen;
+
+    return op - dst;
+}
+
+static inline int get_length(const uint8_t **ip, const uint8_t *iend,
+                             size_t *len)
+{
+    uint8_t b = 0;
+
+    do {
+        if (*ip >= iend) {
+            return -1;
+        }
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return 0;
+}
+
+// returns 0 if the block is decompressed to exactly len bytes.
+static int lz4_decompress(const uint8_t *src, size_t srclen, uint8_t *dst,
+                          size_t len)
+{
+    const uint8_t *ip   = src;
+    const uint8_t *iend = src + srclen;
+    uint8_t *op         = dst;
+    uint8_t *oend       = dst + len;
+
+    while (ip < iend) {
+        unsigned token     = *ip++;
+        size_t n           = token >> 4;
+        size_t offset      = 0;
+        const uint8_t *ref = NULL;
+
+        // literals
+        if (n == 15 && get_length(&ip, iend, &n)) {
+            return -1;
+        } else if ((size_t)(iend - ip) < n || (size_t)(oend - op) < n) {
+            return -1;
+        }
+        memcpy(op, ip, n);
+        op += n;
+        ip += n;
+        if (ip == iend) {
+            // the last sequence has no match
+            break;
+        }
+
+        // match
+        if (iend - ip < 2) {
+            return -1;
+        }
+        offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        n = token & 15;
+        if (n == 15 && get_length(&ip, iend, &n)) {
+            return -1;
+        }
+        n += LZ4_MINMATCH;
+        if (offset == 0 || offset > (size_t)(op - dst) ||
+            (size_t)(oend - op) < n) {
+            return -1;
+        }
+        ref = op - offset;
+        if (offset >= n) {
+            memcpy(op, ref, n);
+            op += n;
+        } else {
+            // the match overlaps the output
+            for (; n; n--) {
+                *op++ = *ref++;
+            }
+        }
+    }
+
+    return (op == oend) ? 0 : -1;
+}
+
+void lmdbx_compress_encode(lua_State *L, size_t threshold, MDBX_val *v)
+{
+    const uint8_t *src = v->iov_base;
+    size_t len         = v->iov_len;
+    uint8_t *buf       = lua_newuserdata(L, 1 + len);
+    size_t zlen        = 0;
+
+    // store compressed only if it is smaller than the raw value
+    if (threshold && len >= threshold && len > HDR_LZ4_LEN &&
+        len <= UINT32_MAX &&
+        (zlen = lz4_compress(src, len, buf + HDR_LZ4_LEN,
+                             len - HDR_LZ4_LEN))) {
+        buf[0] = HDR_LZ4;
+        buf[1] = (uint8_t)len;
+        buf[2] = (uint8_t)(len >> 8);
+        buf[3] = (uint8_t)(len >> 16);
+        buf[4] = (uint8_t)(len >> 24);
+        *v     = (MDBX_val){.iov_base = buf, .iov_len = HDR_LZ4_LEN + zlen};
+        return;
+    }
+    buf[0] = HDR_RAW;
+    if (len) {
+        memcpy(buf + 1, src, len);
+    }
+    *v = (MDBX_val){.iov_base = buf, .iov_len = 1 + len};
+}
+
+int lmdbx_compress_decode(lua_State *L, MDBX_val *v)
+{
+    const uint8_t *p = v->iov_base;
+    size_t len       = 0;
+    uint8_t *buf     = NULL;
+
+    if (v->iov_len == 0) {
+        lua_pushnil(L);
+        return MDBX_SUCCESS;
+    }
+
+    switch (p[0]) {
+    case HDR_RAW:
+        lua_pushnil(L);
+        v->iov_base = (void *)(p + 1);
+        v->iov_len--;
+        return MDBX_SUCCESS;
+
+    case HDR_LZ4:
+        if (v->iov_len < HDR_LZ4_LEN) {
+            break;
+        }
+        len = (size_t)p[1] | ((size_t)p[2] << 8) | ((size_t)p[3] << 16) |
+              ((size_t)p[4] << 24);
+        // a byte of the block cannot be expanded to more than 255 bytes
+        if (len / 255 > v->iov_len - HDR_LZ4_LEN) {
+            break;
+        }
+        buf = lua_newuserdata(L, len);
+        if (lz4_decompress(p + HDR_LZ4_LEN, v->iov_len - HDR_LZ4_LEN, buf,
+                           len)) {
+            lua_pop(L, 1);
+            break;
+        }
+        *v = (MDBX_val){.iov_base = buf, .iov_len = len};
+        return MDBX_SUCCESS;
+    }
+
+    lua_pushnil(L);
+    return MDBX_CORRUPTED;
+}
+
+int lmdbx_compress_pushval(lua_State *L, int viewmode, int txn_ref,
+                           lmdbx_txn_t *txn, const MDBX_val *v)
+{
+    MDBX_val dv = *v;
+    int rc      = lmdbx_compress_decode(L, &dv);
+
+    if (rc) {
+        lua_pop(L, 1);
+        return rc;
+    } else if (lua_isnil(L, -1)) {
+        // the raw value can be referred as a view
+        lua_pop(L, 1);
+        lmdbx_pushval(L, viewmode, txn_ref, txn, 0, &dv);
+        return MDBX_SUCCESS;
+    }
+    lua_pushlstring(L, dv.iov_base, dv.iov_len);
+    lua_replace(L, -2);
+    return MDBX_SUCCESS;
+}
@@ -21,23 +21,106 @@
  **/
 
 #include "lmdbx.h"
+#include <stdlib.h>
 
 // TODO: mdbx_cursor_get_attr
 // TODO: mdbx_cursor_put_attr
 
+#define INTKEY(cur) LMDBX_INTKEY(cur)
+#define INTDUP(cur) LMDBX_INTDUP(cur)
+
+static inline void pushkey(lua_State *L, lmdbx_cursor_t *cur, MDBX_val *k)
+{
+    lmdbx_pushval(L, cur->viewmode, cur->txn_ref, cur->txn, INTKEY(cur), k);
+}
+
+// returns MDBX_CORRUPTED without pushing a value if the value cannot be
+// decompressed.
+static inline int pushval(lua_State *L, lmdbx_cursor_t *cur, MDBX_val *v)
+{
+    if (cur->compress.enabled) {
+        return lmdbx_compress_pushval(L, cur->viewmode, cur->txn_ref,
+                                      cur->txn, v);
+    }
+    lmdbx_pushval(L, cur->viewmode, cur->txn_ref, cur->txn, INTDUP(cur), v);
+    return MDBX_SUCCESS;
+}
+
+// decompress the value if the database enables the compression, and push
+// the buffer of the value, or nil if not decompressed, onto the stack.
+static inline int decompressval(lua_State *L, lmdbx_cursor_t *cur,
+                                MDBX_val *v)
+{
+    if (cur->compress.enabled) {
+        return lmdbx_compress_decode(L, v);
+    }
+    lua_pushnil(L);
+    return MDBX_SUCCESS;
+}
+
+// invalidate the views of the transaction before the cursor modifies it.
+// the cursor does not refer to the transaction after it is closed.
+static inline void bumpgen(lmdbx_cursor_t *cur)
+{
+    if (cur->txn) {
+        cur->txn->gen++;
+    }
+}
+
+static inline int pushkv(lua_State *L, lmdbx_cursor_t *cur, MDBX_val *k,
+                         MDBX_val *v)
+{
+    int rc = 0;
+
+    pushkey(L, cur, k);
+    if ((rc = pushval(L, cur, v))) {
+        lua_pop(L, 1);
+    }
+    return rc;
+}
+
+// push the key and value as the return values, or nil, nil and error if the
+// value cannot be decompressed.
+static inline int retkv(lua_State *L, lmdbx_cursor_t *cur, MDBX_val *k,
+                        MDBX_val *v)
+{
+    int rc = pushkv(L, cur, k, v);
+
+    if (rc) {
+        lua_pushnil(L);
+        lua_pushnil(L);
+        lmdbx_pusherror(L, rc);
+        return 3;
+    }
+    return 2;
+}
+
+static int viewmode_lua(lua_State *L)
+{
+    lmdbx_cursor_t *cur = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
+    int enabled         = cur->viewmode;
+
+    // cur:viewmode([enabled]) returns the previous mode
+    if (!lua_isnoneornil(L, 2)) {
+        cur->viewmode = lauxh_checkboolean(L, 2);
+    }
+    lua_pushboolean(L, enabled);
+    return 1;
+}
+
 static int estimate_move_lua(lua_State *L)
 {
     lmdbx_cursor_t *cur      = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
     MDBX_cursor_op move_op   = lauxh_checkinteger(L, 2);
-    size_t klen              = 0;
-    const char *key          = lauxh_optlstring(L, 3, NULL, &klen);
-    size_t vlen              = 0;
-    const char *val          = lauxh_optlstring(L, 4, NULL, &vlen);
-    MDBX_val k               = {.iov_base = (void *)key, .iov_len = klen};
-    MDBX_val v               = {.iov_base = (void *)val, .iov_len = vlen};
+    lmdbx_intval_t buf[2]    = {0};
+    MDBX_val k               = {0};
+    MDBX_val v               = {0};
     ptrdiff_t distance_items = 0;
-    int rc = mdbx_estimate_move(cur->cur, &k, &v, move_op, &distance_items);
+    int rc                   = 0;
 
+    lmdbx_optval(L, 3, INTKEY(cur), &buf[0], &k);
+    lmdbx_optval(L, 4, INTDUP(cur), &buf[1], &v);
+    rc = mdbx_estimate_move(cur->cur, &k, &v, move_op, &distance_items);
     if (rc) {
         lua_pushnil(L);
         lmdbx_pusherror(L, rc);
@@ -145,7 +228,10 @@ static int del_lua(lua_State *L)
 {
     lmdbx_cursor_t *cur = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
     lua_Integer flags   = lmdbx_checkflags(L, 2);
-    int rc              = mdbx_cursor_del(cur->cur, flags);
+    int rc              = 0;
+
+    bumpgen(cur);
+    rc = mdbx_cursor_del(cur->cur, flags);
 
     if (rc) {
         lua_pushboolean(L, 0);
@@ -160,17 +246,49 @@ static int del_lua(lua_State *L)
 }
 
 static int put_lua(lua_State *L)
+{
+    lmdbx_cursor_t *cur   = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
+    lua_Integer flags     = lmdbx_checkflags(L, 4);
+    lmdbx_intval_t buf[2] = {0};
+    MDBX_val k            = {0};
+    MDBX_val v            = {0};
+    int rc                = 0;
+
+    lmdbx_checkval(L, 2, INTKEY(cur), &buf[0], &k);
+    lmdbx_checkval(L, 3, INTDUP(cur), &buf[1], &v);
+    if (cur->compress.enabled) {
+        lmdbx_compress_encode(L, cur->compress.threshold, &v);
+    }
+    bumpgen(cur);
+    rc = mdbx_cursor_put(cur->cur, &k, &v, flags);
+
+    if (rc) {
+        lua_pushboolean(L, 0);
+        if (rc == MDBX_NOTFOUND) {
+            return 1;
+        }
+        lmdbx_pusherror(L, rc);
+        return 2;
+    }
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+static int put_obj_lua(lua_State *L)
 {
     lmdbx_cursor_t *cur = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
-    size_t klen         = 0;
-    const char *key     = lauxh_checklstring(L, 2, &klen);
-    size_t vlen         = 0;
-    const char *val     = lauxh_checklstring(L, 3, &vlen);
     lua_Integer flags   = lmdbx_checkflags(L, 4);
-    MDBX_val k          = {.iov_base = (void *)key, .iov_len = klen};
-    MDBX_val v          = {.iov_base = (void *)val, .iov_len = vlen};
-    int rc              = mdbx_cursor_put(cur->cur, &k, &v, flags);
+    lmdbx_intval_t buf  = {0};
+    MDBX_val k          = {0};
+    int rc              = 0;
 
+    // cur:put_obj(key, obj [, ...flags])
+    lmdbx_checkval(L, 2, INTKEY(cur), &buf, &k);
+    luaL_checkany(L, 3);
+    lua_settop(L, 3);
+    bumpgen(cur);
+    rc = lmdbx_msgpack_put(L, cur->cur, &k, 3, flags,
+                           cur->flags & MDBX_DUPSORT, &cur->compress);
     if (rc) {
         lua_pushboolean(L, 0);
         if (rc == MDBX_NOTFOUND) {
@@ -183,6 +301,105 @@ static int put_lua(lua_State *L)
     return 1;
 }
 
+static void *check_multiple_values(lua_State *L, int idx, size_t size,
+                                   size_t *n)
+{
+    char *buf  = NULL;
+    size_t len = 0;
+
+    if (lua_type(L, idx) == LUA_TSTRING) {
+        buf = (char *)lua_tolstring(L, idx, &len);
+        if (len % size) {
+            lauxh_argerror(L, idx, "length must be a multiple of %d",
+                           (int)size);
+        }
+        *n = len / size;
+        return buf;
+    }
+
+    luaL_checktype(L, idx, LUA_TTABLE);
+    len = lmdbx_rawlen(L, idx);
+
+    // encode integers in native byte order
+    buf = lua_newuserdata(L, (len) ? len * size : 1);
+    for (size_t i = 0; i < len; i++) {
+        lua_Integer ival = 0;
+
+        lua_rawgeti(L, idx, i + 1);
+        if (lua_type(L, -1) != LUA_TNUMBER) {
+            lauxh_argerror(L, idx, "item#%d must be integer, got %s",
+                           (int)(i + 1), luaL_typename(L, -1));
+        }
+        ival = lua_tointeger(L, -1);
+        lua_pop(L, 1);
+        if (size == sizeof(uint32_t)) {
+            uint32_t u32 = (uint32_t)ival;
+            if (ival < 0 || ival > UINT32_MAX) {
+                lauxh_argerror(L, idx, "item#%d must be in uint32 range",
+                               (int)(i + 1));
+            }
+            memcpy(buf + i * size, &u32, size);
+        } else {
+            int64_t i64 = (int64_t)ival;
+            memcpy(buf + i * size, &i64, size);
+        }
+    }
+    *n = len;
+    return buf;
+}
+
+static int put_multiple_lua(lua_State *L)
+{
+    lmdbx_cursor_t *cur = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
+    lmdbx_intval_t kbuf = {0};
+    MDBX_val k          = {0};
+    int is_str          = lua_type(L, 3) == LUA_TSTRING;
+    int intdup          = (INTDUP(cur)) ? INTDUP(cur) : (int)sizeof(int64_t);
+    lua_Integer size    = (is_str) ? lauxh_checkinteger(L, 4) :
+                                     lauxh_optinteger(L, 4, intdup);
+    lua_Integer flags   = lmdbx_checkflags(L, 5) | MDBX_MULTIPLE;
+    MDBX_val v[2]       = {0};
+    size_t n            = 0;
+    size_t nput         = 0;
+    char *buf           = NULL;
+
+    // cur:put_multiple(key, values [, size [, ...flags]])
+    // the integer values are packed to the size of the integer values of
+    // the INTEGERDUP database by default
+    lmdbx_checkval(L, 2, INTKEY(cur), &kbuf, &k);
+    if (size < 1) {
+        lauxh_argerror(L, 4, "size must be greater than 0");
+    } else if (!is_str && size != sizeof(uint32_t) &&
+               size != sizeof(int64_t)) {
+        lauxh_argerror(L, 4, "size must be 4 or 8 for integer values");
+    }
+    buf = check_multiple_values(L, 3, size, &n);
+
+    bumpgen(cur);
+    while (nput < n) {
+        int rc = 0;
+
+        // v[0] is the first item, v[1].iov_len is the number of items and
+        // is updated to the number of items actually written
+        v[0].iov_base = buf + nput * size;
+        v[0].iov_len  = size;
+        v[1].iov_base = NULL;
+        v[1].iov_len  = n - nput;
+        rc            = mdbx_cursor_put(cur->cur, &k, v, flags);
+        if (rc) {
+            lua_pushnil(L);
+            lmdbx_pusherror(L, rc);
+            lua_pushinteger(L, nput);
+            return 3;
+        } else if (v[1].iov_len == 0) {
+            break;
+        }
+        nput += v[1].iov_len;
+    }
+    lua_pushinteger(L, nput);
+    return 1;
+}
+
 static int get_batch_lua(lua_State *L)
 {
     lmdbx_cursor_t *cur = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
@@ -190,9 +407,22 @@ static int get_batch_lua(lua_State *L)
     lua_Integer op      = lauxh_optinteger(L, 3, MDBX_FIRST);
     size_t limit        = npair * 2;
     size_t count        = 0;
-    MDBX_val *pairs     = lua_newuserdata(L, sizeof(MDBX_val) * limit);
-    int rc = mdbx_cursor_get_batch(cur->cur, &count, pairs, limit, op);
+    MDBX_val *pairs     = cur->batch;
+    int rc              = 0;
+
+    if (limit > cur->nbatch) {
+        // grow the scratch buffer
+        pairs = realloc(cur->batch, sizeof(MDBX_val) * limit);
+        if (!pairs) {
+            lua_pushnil(L);
+            lmdbx_pusherror(L, MDBX_ENOMEM);
+            return 2;
+        }
+        cur->batch  = pairs;
+        cur->nbatch = limit;
+    }
 
+    rc = mdbx_cursor_get_batch(cur->cur, &count, pairs, limit, op);
     if (rc) {
         if (rc == MDBX_NOTFOUND) {
             return 0;
@@ -203,24 +433,529 @@ static int get_batch_lua(lua_State *L)
     }
     lua_createtable(L, 0, count / 2);
     for (size_t i = 0; i < count; i += 2) {
-        lua_pushlstring(L, pairs[i].iov_base, pairs[i].iov_len);
-        lua_pushlstring(L, pairs[i + 1].iov_base, pairs[i + 1].iov_len);
+        if ((rc = pushkv(L, cur, &pairs[i], &pairs[i + 1]))) {
+            lua_pushnil(L);
+            lmdbx_pusherror(L, rc);
+            return 2;
+        }
         lua_rawset(L, -3);
     }
     return 1;
 }
 
+// returns the operation to move to the following items of the op. the
+// stepping operations keep skipping or staying in the duplicates.
+static inline MDBX_cursor_op batch_step(MDBX_cursor_op op)
+{
+    switch (op) {
+    case MDBX_NEXT_DUP:
+    case MDBX_NEXT_NODUP:
+    case MDBX_PREV_DUP:
+    case MDBX_PREV_NODUP:
+        return op;
+    case MDBX_LAST:
+    case MDBX_LAST_DUP:
+    case MDBX_PREV:
+        return MDBX_PREV;
+    default:
+        return MDBX_NEXT;
+    }
+}
+
+// returns the operation to move back from the item stepped by the step
+static inline MDBX_cursor_op batch_back(MDBX_cursor_op step)
+{
+    switch (step) {
+    case MDBX_NEXT:
+    case MDBX_NEXT_DUP:
+    case MDBX_NEXT_NODUP:
+        return MDBX_PREV;
+    default:
+        return MDBX_NEXT;
+    }
+}
+
+// returns MDBX_RESULT_TRUE if no more items in the direction of the step,
+// or MDBX_RESULT_FALSE if more items. the next item is peeked and the cursor
+// is moved back, because mdbx_cursor_on_last and mdbx_cursor_on_first do not
+// take the remaining duplicates into account.
+static inline int batch_eof(lmdbx_cursor_t *cur, MDBX_cursor_op step)
+{
+    MDBX_val k = {0};
+    MDBX_val v = {0};
+    int rc     = mdbx_cursor_get(cur->cur, &k, &v, step);
+
+    if (rc == MDBX_NOTFOUND) {
+        return MDBX_RESULT_TRUE;
+    } else if (rc == MDBX_SUCCESS) {
+        rc = mdbx_cursor_get(cur->cur, &k, &v, batch_back(step));
+    }
+    return rc;
+}
+
+static int get_batch_list_lua(lua_State *L)
+{
+    lmdbx_cursor_t *cur = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
+    lua_Integer npair   = lauxh_optuint16(L, 2, 0xFF);
+    MDBX_cursor_op op   = lauxh_optinteger(L, 3, MDBX_NEXT);
+    MDBX_cursor_op step = batch_step(op);
+    MDBX_val k          = {0};
+    MDBX_val v          = {0};
+    int eof             = 0;
+    int rc              = 0;
+    int n               = 0;
+
+    // cur:get_batch_list([npair [, op [, keys [, vals]]]])
+    lua_settop(L, 5);
+    if (lua_isnil(L, 4)) {
+        lua_createtable(L, npair, 0);
+        lua_replace(L, 4);
+    }
+    luaL_checktype(L, 4, LUA_TTABLE);
+    if (lua_isnil(L, 5)) {
+        lua_createtable(L, npair, 0);
+        lua_replace(L, 5);
+    }
+    luaL_checktype(L, 5, LUA_TTABLE);
+
+    while (n < npair) {
+        rc = mdbx_cursor_get(cur->cur, &k, &v, op);
+        if (rc || (rc = pushval(L, cur, &v))) {
+            if (rc != MDBX_NOTFOUND) {
+                lua_pushnil(L);
+                lua_pushnil(L);
+                lua_pushnil(L);
+                lmdbx_pusherror(L, rc);
+                return 4;
+            }
+            eof = 1;
+            break;
+        }
+        n++;
+        lua_rawseti(L, 5, n);
+        pushkey(L, cur, &k);
+        lua_rawseti(L, 4, n);
+        op = step;
+    }
+
+    // remove stale items of the previous batch
+    for (int i = n + 1;; i++) {
+        lua_rawgeti(L, 4, i);
+        lua_rawgeti(L, 5, i);
+        if (lua_isnil(L, -1) && lua_isnil(L, -2)) {
+            lua_pop(L, 2);
+            break;
+        }
+        lua_pop(L, 2);
+        lua_pushnil(L);
+        lua_rawseti(L, 4, i);
+        lua_pushnil(L);
+        lua_rawseti(L, 5, i);
+    }
+
+    if (!eof && n > 0) {
+        if ((rc = batch_eof(cur, step)) == MDBX_RESULT_TRUE) {
+            eof = 1;
+        } else if (rc) {
+            lua_pushnil(L);
+            lua_pushnil(L);
+            lua_pushnil(L);
+            lmdbx_pusherror(L, rc);
+            return 4;
+        }
+    }
+    lua_pushboolean(L, eof);
+    return 3;
+}
+
+static int project_lua(lua_State *L)
+{
+    lmdbx_cursor_t *cur   = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
+    lmdbx_schema_t *s     = lauxh_checkudata(L, 2, LMDBX_SCHEMA_MT);
+    lua_Integer limit     = lauxh_optuint16(L, 4, 0xFF);
+    MDBX_cursor_op op     = lauxh_optinteger(L, 5, MDBX_NEXT);
+    MDBX_cursor_op step   = batch_step(op);
+    lmdbx_field_t **flds  = NULL;
+    int nfield            = 0;
+    MDBX_val k            = {0};
+    MDBX_val v            = {0};
+    int eof               = 0;
+    int rc                = 0;
+    int n                 = 0;
+
+    // cur:project(schema, fields [, limit [, op]])
+    // read the specified fields of the records into the column arrays
+    luaL_checktype(L, 3, LUA_TTABLE);
+    lua_settop(L, 5);
+    nfield = (int)lmdbx_rawlen(L, 3);
+    if (nfield < 1) {
+        lauxh_argerror(L, 3, "at least one field must be specified");
+    }
+    luaL_checkstack(L, nfield + 4, "too many fields");
+    flds = lua_newuserdata(L, sizeof(lmdbx_field_t *) * nfield);
+    for (int i = 0; i < nfield; i++) {
+        lua_rawgeti(L, 3, i + 1);
+        flds[i] = lmdbx_schema_checkfield(L, s, lua_gettop(L));
+        lua_pop(L, 1);
+    }
+
+    // keys, columns and each column at 7, 8 and 9..
+    lua_createtable(L, limit, 0);
+    lua_createtable(L, nfield, 0);
+    for (int i = 0; i < nfield; i++) {
+        lua_createtable(L, limit, 0);
+        lua_pushvalue(L, -1);
+        lua_rawseti(L, 8, i + 1);
+    }
+
+    while (n < limit) {
+        rc = mdbx_cursor_get(cur->cur, &k, &v, op);
+        if (rc) {
+            if (rc != MDBX_NOTFOUND) {
+                goto FAIL;
+            }
+            eof = 1;
+            break;
+        }
+        n++;
+        pushkey(L, cur, &k);
+        lua_rawseti(L, 7, n);
+        if ((rc = decompressval(L, cur, &v))) {
+            goto FAIL;
+        }
+        for (int i = 0; i < nfield; i++) {
+            if ((rc = lmdbx_schema_pushfield(L, flds[i], &v))) {
+                goto FAIL;
+            }
+            lua_rawseti(L, 9 + i, n);
+        }
+        lua_pop(L, 1);
+        op = step;
+    }
+    if (!eof && n > 0) {
+        if ((rc = batch_eof(cur, step)) == MDBX_RESULT_TRUE) {
+            eof = 1;
+        } else if (rc) {
+            goto FAIL;
+        }
+    }
+    lua_settop(L, 8);
+    lua_pushboolean(L, eof);
+    return 3;
+
+FAIL:
+    lua_pushnil(L);
+    lua_pushnil(L);
+    lua_pushnil(L);
+    lmdbx_pusherror(L, rc);
+    return 4;
+}
+
+// number of MDBX_NEXT steps tried before seeking with MDBX_SET_RANGE
+#define JOIN_SCAN 8
+
+// move the cursor to the first key that is equal to or greater than the
+// target. the cursor is stepped forward if the target is near, or seeks it
+// from the root.
+static int join_seek(lmdbx_cursor_t *cur, MDBX_val *k, MDBX_val *v,
+                     MDBX_cursor_op step, const MDBX_val *target)
+{
+    MDBX_txn *txn = mdbx_cursor_txn(cur->cur);
+    MDBX_dbi dbi  = mdbx_cursor_dbi(cur->cur);
+    int rc        = 0;
+
+    for (int i = 0; i < JOIN_SCAN; i++) {
+        if ((rc = mdbx_cursor_get(cur->cur, k, v, step))) {
+            return rc;
+        } else if (mdbx_cmp(txn, dbi, k, target) >= 0) {
+            return MDBX_SUCCESS;
+        }
+    }
+    *k = *target;
+    return mdbx_cursor_get(cur->cur, k, v, MDBX_SET_RANGE);
+}
+
+static inline int join_current(lmdbx_cursor_t *cur, MDBX_val *k,
+                               MDBX_val *v)
+{
+    if (mdbx_cursor_eof(cur->cur) == MDBX_RESULT_TRUE) {
+        return MDBX_NOTFOUND;
+    }
+    return mdbx_cursor_get(cur->cur, k, v, MDBX_GET_CURRENT);
+}
+
+static int join_batch_lua(lua_State *L)
+{
+    lmdbx_cursor_t *cur   = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
+    lmdbx_cursor_t *other = lauxh_checkudata(L, 2, LMDBX_CURSOR_MT);
+    lua_Integer limit     = lauxh_optuint16(L, 3, 0xFF);
+    MDBX_txn *txn         = mdbx_cursor_txn(cur->cur);
+    MDBX_dbi dbi          = mdbx_cursor_dbi(cur->cur);
+    MDBX_val lk           = {0};
+    MDBX_val lv           = {0};
+    MDBX_val rk           = {0};
+    MDBX_val rv           = {0};
+    int eof               = 0;
+    int rc                = 0;
+    int n                 = 0;
+
+    // cur:join_batch(other [, limit])
+    // merge join the keys of the cursor with the keys of the other cursor
+    // from their current positions, and read up to limit matched items.
+    // both databases must have the same key order. the value of the other
+    // cursor is the first value of the key.
+    // returns the keys, the values of the cursor, the values of the other
+    // cursor and eof. the cursor is moved to the next item of the last
+    // matched item, so that the next call continues the join.
+    lua_settop(L, 3);
+    lua_createtable(L, limit, 0);
+    lua_createtable(L, limit, 0);
+    lua_createtable(L, limit, 0);
+
+    if ((rc = join_current(cur, &lk, &lv)) == MDBX_SUCCESS) {
+        rc = join_current(other, &rk, &rv);
+    }
+    while (rc == MDBX_SUCCESS && n < limit) {
+        int cmp = mdbx_cmp(txn, dbi, &lk, &rk);
+
+        if (cmp == 0) {
+            n++;
+            pushkey(L, cur, &lk);
+            lua_rawseti(L, 4, n);
+            if ((rc = pushval(L, cur, &lv))) {
+                break;
+            }
+            lua_rawseti(L, 5, n);
+            if ((rc = pushval(L, other, &rv))) {
+                break;
+            }
+            lua_rawseti(L, 6, n);
+            // the duplicates of the cursor are joined with the same item
+            rc = mdbx_cursor_get(cur->cur, &lk, &lv, MDBX_NEXT);
+        } else if (cmp < 0) {
+            rc = join_seek(cur, &lk, &lv, MDBX_NEXT, &rk);
+        } else {
+            rc = join_seek(other, &rk, &rv, MDBX_NEXT_NODUP, &lk);
+        }
+    }
+    if (rc) {
+        if (rc != MDBX_NOTFOUND) {
+            lua_pushnil(L);
+            lua_pushnil(L);
+            lua_pushnil(L);
+            lua_pushnil(L);
+            lmdbx_pusherror(L, rc);
+            return 5;
+        }
+        eof = 1;
+    }
+    lua_pushboolean(L, eof);
+    return 4;
+}
+
+// a position token is an opaque string that holds the key, and the value
+// for the duplicates, of the cursor position.
+//
+//  <version> <flags> <varint length of key> <key> [<value>]
+#define TOKEN_VERSION  0x01
+#define TOKEN_HAS_DATA 0x01
+
+static int position_token_lua(lua_State *L)
+{
+    lmdbx_cursor_t *cur = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
+    MDBX_val k          = {0};
+    MDBX_val v          = {0};
+    int dupsort         = (cur->flags & MDBX_DUPSORT) != 0;
+    luaL_Buffer b;
+    size_t len = 0;
+    int rc     = 0;
+
+    // cur:position_token()
+    rc = mdbx_cursor_get(cur->cur, &k, &v, MDBX_GET_CURRENT);
+    if (rc) {
+        if (rc == MDBX_NOTFOUND || rc == MDBX_ENODATA) {
+            return 0;
+        }
+        lua_pushnil(L);
+        lmdbx_pusherror(L, rc);
+        return 2;
+    }
+
+    luaL_buffinit(L, &b);
+    luaL_addchar(&b, TOKEN_VERSION);
+    luaL_addchar(&b, (dupsort) ? TOKEN_HAS_DATA : 0);
+    for (len = k.iov_len; len >= 0x80; len >>= 7) {
+        luaL_addchar(&b, (char)(0x80 | (len & 0x7f)));
+    }
+    luaL_addchar(&b, (char)len);
+    luaL_addlstring(&b, k.iov_base, k.iov_len);
+    if (dupsort) {
+        luaL_addlstring(&b, v.iov_base, v.iov_len);
+    }
+    luaL_pushresult(&b);
+    return 1;
+}
+
+// returns 0 if the token is valid.
+static int parse_token(const char *p, size_t len, MDBX_val *k, MDBX_val *v,
+                       int *has_data)
+{
+    const char *end = p + len;
+    size_t klen     = 0;
+
+    if (len < 3 || p[0] != TOKEN_VERSION || (p[1] & ~TOKEN_HAS_DATA)) {
+        return -1;
+    }
+    *has_data = p[1] & TOKEN_HAS_DATA;
+    p += 2;
+    for (int shift = 0;; shift += 7) {
+        if (p == end || shift > 56) {
+            return -1;
+        }
+        klen |= (size_t)(*p & 0x7f) << shift;
+        if (!(*p++ & 0x80)) {
+            break;
+        }
+    }
+    if ((size_t)(end - p) < klen ||
+        // only the token with the value has bytes after the key
+        (!*has_data && (size_t)(end - p) != klen)) {
+        return -1;
+    }
+    *k = (MDBX_val){.iov_base = (void *)p, .iov_len = klen};
+    *v = (MDBX_val){.iov_base = (void *)(p + klen),
+                    .iov_len  = end - p - klen};
+    return 0;
+}
+
+// move the cursor to the first item after the position of the token, or to
+// the last item before the position if reverse is true.
+static int resume(lmdbx_cursor_t *cur, const MDBX_val *tk, const MDBX_val *tv,
+                  int has_data, int reverse, MDBX_val *k, MDBX_val *v)
+{
+    MDBX_txn *txn = mdbx_cursor_txn(cur->cur);
+    MDBX_dbi dbi  = mdbx_cursor_dbi(cur->cur);
+    int rc        = 0;
+
+    if (has_data && (cur->flags & MDBX_DUPSORT)) {
+        // find the first duplicate that is equal to or greater than the
+        // value of the token
+        *k = *tk;
+        *v = *tv;
+        rc = mdbx_cursor_get(cur->cur, k, v, MDBX_GET_BOTH_RANGE);
+        if (rc == MDBX_SUCCESS) {
+            if (reverse) {
+                return mdbx_cursor_get(cur->cur, k, v, MDBX_PREV);
+            } else if (mdbx_dcmp(txn, dbi, v, tv) == 0) {
+                return mdbx_cursor_get(cur->cur, k, v, MDBX_NEXT);
+            }
+            return MDBX_SUCCESS;
+        } else if (rc != MDBX_NOTFOUND) {
+            return rc;
+        }
+        // all duplicates of the key are less than the value, or the key
+        // does not exist
+    }
+
+    *k = *tk;
+    rc = mdbx_cursor_get(cur->cur, k, v, MDBX_SET_RANGE);
+    if (rc == MDBX_NOTFOUND) {
+        // all keys are less than the key of the token
+        return (reverse) ? mdbx_cursor_get(cur->cur, k, v, MDBX_LAST) : rc;
+    } else if (rc) {
+        return rc;
+    } else if (mdbx_cmp(txn, dbi, k, tk) != 0) {
+        // the key of the token has been deleted
+        return (reverse) ? mdbx_cursor_get(cur->cur, k, v, MDBX_PREV) :
+                           MDBX_SUCCESS;
+    } else if (!has_data || !(cur->flags & MDBX_DUPSORT)) {
+        return mdbx_cursor_get(cur->cur, k, v,
+                               (reverse) ? MDBX_PREV : MDBX_NEXT_NODUP);
+    } else if (reverse) {
+        return mdbx_cursor_get(cur->cur, k, v, MDBX_LAST_DUP);
+    }
+    return mdbx_cursor_get(cur->cur, k, v, MDBX_NEXT_NODUP);
+}
+
+static int resume_lua(lua_State *L)
+{
+    lmdbx_cursor_t *cur = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
+    size_t len          = 0;
+    const char *token   = lauxh_checklstring(L, 2, &len);
+    int reverse         = lauxh_optboolean(L, 3, 0);
+    MDBX_val tk         = {0};
+    MDBX_val tv         = {0};
+    MDBX_val k          = {0};
+    MDBX_val v          = {0};
+    int has_data        = 0;
+    int rc              = 0;
+
+    // cur:resume(token [, reverse])
+    // move the cursor to the item next to the position of the token in the
+    // direction, and returns the key and value of the item.
+    if (parse_token(token, len, &tk, &tv, &has_data)) {
+        rc = MDBX_EINVAL;
+    } else {
+        rc = resume(cur, &tk, &tv, has_data, reverse, &k, &v);
+    }
+    if (rc) {
+        if (rc == MDBX_NOTFOUND) {
+            return 0;
+        }
+        lua_pushnil(L);
+        lua_pushnil(L);
+        lmdbx_pusherror(L, rc);
+        return 3;
+    }
+    return retkv(L, cur, &k, &v);
+}
+
 static int get_lua(lua_State *L)
+{
+    lmdbx_cursor_t *cur   = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
+    lua_Integer op        = lauxh_optinteger(L, 2, MDBX_GET_CURRENT);
+    lmdbx_intval_t buf[2] = {0};
+    MDBX_val k            = {0};
+    MDBX_val v            = {0};
+    int rc                = 0;
+
+    lmdbx_optval(L, 3, INTKEY(cur), &buf[0], &k);
+    lmdbx_optval(L, 4, INTDUP(cur), &buf[1], &v);
+    rc = mdbx_cursor_get(cur->cur, &k, &v, op);
+    if (rc) {
+        if (rc == MDBX_NOTFOUND) {
+            return 0;
+        }
+        lua_pushnil(L);
+        lua_pushnil(L);
+        lmdbx_pusherror(L, rc);
+        return 3;
+    }
+    return retkv(L, cur, &k, &v);
+}
+
+static int get_obj_lua(lua_State *L)
 {
     lmdbx_cursor_t *cur = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
     lua_Integer op      = lauxh_optinteger(L, 2, MDBX_GET_CURRENT);
+    lmdbx_intval_t buf  = {0};
     MDBX_val k          = {0};
     MDBX_val v          = {0};
     int rc              = 0;
 
-    k.iov_base = (void *)lauxh_optlstring(L, 3, NULL, &k.iov_len);
-    v.iov_base = (void *)lauxh_optlstring(L, 4, NULL, &v.iov_len);
-    rc         = mdbx_cursor_get(cur->cur, &k, &v, op);
+    // cur:get_obj([op [, key]])
+    lmdbx_optval(L, 3, INTKEY(cur), &buf, &k);
+    rc = mdbx_cursor_get(cur->cur, &k, &v, op);
+    if (rc == MDBX_SUCCESS) {
+        pushkey(L, cur, &k);
+        if ((rc = decompressval(L, cur, &v)) ||
+            (rc = lmdbx_msgpack_decode(L, &v))) {
+            lua_pop(L, 2);
+        } else {
+            // remove the buffer of the decompressed value
+            lua_remove(L, -2);
+        }
+    }
     if (rc) {
         if (rc == MDBX_NOTFOUND) {
             return 0;
@@ -230,8 +965,6 @@ static int get_lua(lua_State *L)
         lmdbx_pusherror(L, rc);
         return 3;
     }
-    lua_pushlstring(L, k.iov_base, k.iov_len);
-    lua_pushlstring(L, v.iov_base, v.iov_len);
     return 2;
 }
 
@@ -251,11 +984,83 @@ static inline int cursor_get_with_noarg_lua(lua_State *L, MDBX_cursor_op op)
         lmdbx_pusherror(L, rc);
         return 3;
     }
-    lua_pushlstring(L, k.iov_base, k.iov_len);
-    lua_pushlstring(L, v.iov_base, v.iov_len);
+    return retkv(L, cur, &k, &v);
+}
+
+static void push_multiple_values(lua_State *L, MDBX_val *v, size_t size)
+{
+    const char *data = v->iov_base;
+    size_t n         = (size) ? v->iov_len / size : 0;
+
+    lua_createtable(L, n, 0);
+    for (size_t i = 0; i < n; i++) {
+        const char *p = data + i * size;
+        if (size == sizeof(uint32_t)) {
+            uint32_t u32 = 0;
+            memcpy(&u32, p, sizeof(u32));
+            lua_pushinteger(L, (lua_Integer)u32);
+        } else if (size == sizeof(int64_t)) {
+            int64_t i64 = 0;
+            memcpy(&i64, p, sizeof(i64));
+            lua_pushinteger(L, (lua_Integer)i64);
+        } else {
+            lua_pushlstring(L, p, size);
+        }
+        lua_rawseti(L, -2, i + 1);
+    }
+}
+
+static inline int cursor_get_multiple_lua(lua_State *L, MDBX_cursor_op op)
+{
+    lmdbx_cursor_t *cur = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
+    int decode          = lauxh_optboolean(L, 2, 0);
+    MDBX_val k          = {0};
+    MDBX_val v          = {0};
+    MDBX_val ck         = {0};
+    MDBX_val cv         = {0};
+    int rc              = mdbx_cursor_get(cur->cur, &k, &v, op);
+
+    if (rc == MDBX_SUCCESS && decode) {
+        // the current item holds a single value of the fixed size
+        rc = mdbx_cursor_get(cur->cur, &ck, &cv, MDBX_GET_CURRENT);
+    }
+    if (rc) {
+        if (rc == MDBX_NOTFOUND) {
+            return 0;
+        }
+        lua_pushnil(L);
+        lua_pushnil(L);
+        lmdbx_pusherror(L, rc);
+        return 3;
+    }
+
+    pushkey(L, cur, &k);
+    if (!decode) {
+        // the page of the packed values is not an integer even if its size
+        // is the same as an integer. the values of DUPFIXED database are not
+        // compressed.
+        lmdbx_pushval(L, cur->viewmode, cur->txn_ref, cur->txn, 0, &v);
+        return 2;
+    }
+    push_multiple_values(L, &v, cv.iov_len);
     return 2;
 }
 
+static int prev_multiple_lua(lua_State *L)
+{
+    return cursor_get_multiple_lua(L, MDBX_PREV_MULTIPLE);
+}
+
+static int next_multiple_lua(lua_State *L)
+{
+    return cursor_get_multiple_lua(L, MDBX_NEXT_MULTIPLE);
+}
+
+static int get_multiple_lua(lua_State *L)
+{
+    return cursor_get_multiple_lua(L, MDBX_GET_MULTIPLE);
+}
+
 static int get_prev_nodup_lua(lua_State *L)
 {
     return cursor_get_with_noarg_lua(L, MDBX_PREV_NODUP);
@@ -306,21 +1111,25 @@ static int get_first_lua(lua_State *L)
     return cursor_get_with_noarg_lua(L, MDBX_FIRST);
 }
 
-static inline int cursor_get_with_key_and_optvalue(lua_State *L, MDBX_val *k,
-                                                   MDBX_val *v,
+static inline int cursor_get_with_key_and_optvalue(lua_State *L,
+                                                   lmdbx_cursor_t *cur,
+                                                   MDBX_val *k, MDBX_val *v,
                                                    MDBX_cursor_op op)
 {
-    lmdbx_cursor_t *cur = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
-    k->iov_base         = (void *)lauxh_checklstring(L, 2, &k->iov_len);
-    v->iov_base         = (void *)lauxh_optlstring(L, 3, NULL, &v->iov_len);
+    lmdbx_intval_t buf[2] = {0};
+
+    lmdbx_checkval(L, 2, INTKEY(cur), &buf[0], k);
+    lmdbx_optval(L, 3, INTDUP(cur), &buf[1], v);
     return mdbx_cursor_get(cur->cur, k, v, op);
 }
 
 static int get_both_range_lua(lua_State *L)
 {
-    MDBX_val k = {0};
-    MDBX_val v = {0};
-    int rc = cursor_get_with_key_and_optvalue(L, &k, &v, MDBX_GET_BOTH_RANGE);
+    lmdbx_cursor_t *cur = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
+    MDBX_val k          = {0};
+    MDBX_val v          = {0};
+    int rc =
+        cursor_get_with_key_and_optvalue(L, cur, &k, &v, MDBX_GET_BOTH_RANGE);
 
     if (rc) {
         if (rc == MDBX_NOTFOUND) {
@@ -331,21 +1140,20 @@ static int get_both_range_lua(lua_State *L)
         lmdbx_pusherror(L, rc);
         return 3;
     }
-    lua_pushlstring(L, k.iov_base, k.iov_len);
-    lua_pushlstring(L, v.iov_base, v.iov_len);
-    return 2;
+    return retkv(L, cur, &k, &v);
 }
 
 static int get_both_lua(lua_State *L)
 {
-    lmdbx_cursor_t *cur = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
-    MDBX_val k          = {0};
-    MDBX_val v          = {0};
-    int rc              = 0;
-
-    k.iov_base = (void *)lauxh_checklstring(L, 2, &k.iov_len);
-    v.iov_base = (void *)lauxh_checklstring(L, 3, &v.iov_len);
-    rc         = mdbx_cursor_get(cur->cur, &k, &v, MDBX_GET_BOTH);
+    lmdbx_cursor_t *cur   = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
+    lmdbx_intval_t buf[2] = {0};
+    MDBX_val k            = {0};
+    MDBX_val v            = {0};
+    int rc                = 0;
+
+    lmdbx_checkval(L, 2, INTKEY(cur), &buf[0], &k);
+    lmdbx_checkval(L, 3, INTDUP(cur), &buf[1], &v);
+    rc = mdbx_cursor_get(cur->cur, &k, &v, MDBX_GET_BOTH);
     if (rc) {
         if (rc == MDBX_NOTFOUND) {
             return 0;
@@ -355,16 +1163,16 @@ static int get_both_lua(lua_State *L)
         lmdbx_pusherror(L, rc);
         return 3;
     }
-    lua_pushlstring(L, k.iov_base, k.iov_len);
-    lua_pushlstring(L, v.iov_base, v.iov_len);
-    return 2;
+    return retkv(L, cur, &k, &v);
 }
 
 static int set_upperbound_lua(lua_State *L)
 {
-    MDBX_val k = {0};
-    MDBX_val v = {0};
-    int rc = cursor_get_with_key_and_optvalue(L, &k, &v, MDBX_SET_UPPERBOUND);
+    lmdbx_cursor_t *cur = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
+    MDBX_val k          = {0};
+    MDBX_val v          = {0};
+    int rc =
+        cursor_get_with_key_and_optvalue(L, cur, &k, &v, MDBX_SET_UPPERBOUND);
 
     if (rc) {
         switch (rc) {
@@ -382,16 +1190,16 @@ static int set_upperbound_lua(lua_State *L)
         }
     }
 
-    lua_pushlstring(L, k.iov_base, k.iov_len);
-    lua_pushlstring(L, v.iov_base, v.iov_len);
-    return 2;
+    return retkv(L, cur, &k, &v);
 }
 
 static int set_lowerbound_lua(lua_State *L)
 {
-    MDBX_val k = {0};
-    MDBX_val v = {0};
-    int rc = cursor_get_with_key_and_optvalue(L, &k, &v, MDBX_SET_LOWERBOUND);
+    lmdbx_cursor_t *cur = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
+    MDBX_val k          = {0};
+    MDBX_val v          = {0};
+    int rc =
+        cursor_get_with_key_and_optvalue(L, cur, &k, &v, MDBX_SET_LOWERBOUND);
 
     if (rc) {
         switch (rc) {
@@ -410,24 +1218,25 @@ static int set_lowerbound_lua(lua_State *L)
         }
     }
 
-    lua_pushlstring(L, k.iov_base, k.iov_len);
-    lua_pushlstring(L, v.iov_base, v.iov_len);
-    return 2;
+    return retkv(L, cur, &k, &v);
 }
 
-static inline int cursor_get_with_key(lua_State *L, MDBX_val *k, MDBX_val *v,
+static inline int cursor_get_with_key(lua_State *L, lmdbx_cursor_t *cur,
+                                      MDBX_val *k, MDBX_val *v,
                                       MDBX_cursor_op op)
 {
-    lmdbx_cursor_t *cur = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
-    k->iov_base         = (void *)lauxh_checklstring(L, 2, &k->iov_len);
+    lmdbx_intval_t buf = {0};
+
+    lmdbx_checkval(L, 2, INTKEY(cur), &buf, k);
     return mdbx_cursor_get(cur->cur, k, v, op);
 }
 
 static int set_range_lua(lua_State *L)
 {
-    MDBX_val k = {0};
-    MDBX_val v = {0};
-    int rc     = cursor_get_with_key(L, &k, &v, MDBX_SET_RANGE);
+    lmdbx_cursor_t *cur = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
+    MDBX_val k          = {0};
+    MDBX_val v          = {0};
+    int rc              = cursor_get_with_key(L, cur, &k, &v, MDBX_SET_RANGE);
 
     if (rc) {
         if (rc == MDBX_NOTFOUND) {
@@ -438,18 +1247,17 @@ static int set_range_lua(lua_State *L)
         lmdbx_pusherror(L, rc);
         return 3;
     }
-    lua_pushlstring(L, k.iov_base, k.iov_len);
-    lua_pushlstring(L, v.iov_base, v.iov_len);
-    return 2;
+    return retkv(L, cur, &k, &v);
 }
 
 static int set_lua(lua_State *L)
 {
-    MDBX_val k = {0};
-    MDBX_val v = {0};
-    int rc     = cursor_get_with_key(L, &k, &v, MDBX_SET);
+    lmdbx_cursor_t *cur = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
+    MDBX_val k          = {0};
+    MDBX_val v          = {0};
+    int rc              = cursor_get_with_key(L, cur, &k, &v, MDBX_SET);
 
-    if (rc) {
+    if (rc || (rc = pushval(L, cur, &v))) {
         if (rc == MDBX_NOTFOUND) {
             return 0;
         }
@@ -457,18 +1265,270 @@ static int set_lua(lua_State *L)
         lmdbx_pusherror(L, rc);
         return 2;
     }
-    lua_pushlstring(L, v.iov_base, v.iov_len);
     return 1;
 }
 
+typedef struct {
+    int reverse;
+    int start_inclusive;
+    int stop_inclusive;
+    int dupsort;
+    int started;
+    int done;
+    lua_Integer limit;
+    lua_Integer count;
+    // the values that do not match are skipped if not NULL
+    const lmdbx_filter_t *filter;
+} range_t;
+
+#define RANGE_CURSOR lua_upvalueindex(2)
+#define RANGE_START  lua_upvalueindex(3)
+#define RANGE_STOP   lua_upvalueindex(4)
+#define RANGE_STATE  lua_upvalueindex(5)
+#define RANGE_FILTER lua_upvalueindex(6)
+
+static inline int range_toval(lua_State *L, int idx, MDBX_val *v)
+{
+    if (lua_isnil(L, idx)) {
+        return 0;
+    }
+    v->iov_base = (void *)lua_tolstring(L, idx, &v->iov_len);
+    return 1;
+}
+
+static int range_seek(lua_State *L, lmdbx_cursor_t *cur, range_t *r,
+                      MDBX_val *k, MDBX_val *v)
+{
+    MDBX_txn *txn  = mdbx_cursor_txn(cur->cur);
+    MDBX_dbi dbi   = mdbx_cursor_dbi(cur->cur);
+    MDBX_val bound = {0};
+    int rc         = 0;
+
+    if (!r->reverse) {
+        if (!range_toval(L, RANGE_START, &bound)) {
+            return mdbx_cursor_get(cur->cur, k, v, MDBX_FIRST);
+        }
+        *k = bound;
+        rc = mdbx_cursor_get(cur->cur, k, v, MDBX_SET_RANGE);
+        if (rc == MDBX_SUCCESS && !r->start_inclusive &&
+            mdbx_cmp(txn, dbi, k, &bound) == 0) {
+            // skip all items of the start key
+            rc = mdbx_cursor_get(cur->cur, k, v, MDBX_NEXT_NODUP);
+        }
+        return rc;
+    }
+
+    if (!range_toval(L, RANGE_STOP, &bound)) {
+        return mdbx_cursor_get(cur->cur, k, v, MDBX_LAST);
+    }
+    *k = bound;
+    rc = mdbx_cursor_get(cur->cur, k, v, MDBX_SET_RANGE);
+    switch (rc) {
+    case MDBX_SUCCESS:
+        if (r->stop_inclusive && mdbx_cmp(txn, dbi, k, &bound) == 0) {
+            // start from the last item of the stop key
+            return (r->dupsort) ?
+                       mdbx_cursor_get(cur->cur, k, v, MDBX_LAST_DUP) :
+                       MDBX_SUCCESS;
+        }
+        return mdbx_cursor_get(cur->cur, k, v, MDBX_PREV);
+
+    case MDBX_NOTFOUND:
+        // all keys are less than the stop key
+        return mdbx_cursor_get(cur->cur, k, v, MDBX_LAST);
+
+    default:
+        return rc;
+    }
+}
+
+// returns 1 if the value matches the filter of the range.
+static int range_match(lua_State *L, lmdbx_cursor_t *cur, range_t *r,
+                       MDBX_val *v, int *rc)
+{
+    MDBX_val dv = *v;
+    int match   = 0;
+
+    if (!r->filter) {
+        return 1;
+    } else if ((*rc = decompressval(L, cur, &dv))) {
+        lua_pop(L, 1);
+        return 0;
+    }
+    match = lmdbx_filter_match(r->filter, &dv);
+    lua_pop(L, 1);
+    return match;
+}
+
+static int range_next_lua(lua_State *L)
+{
+    lmdbx_cursor_t *cur = lua_touserdata(L, RANGE_CURSOR);
+    range_t *r          = lua_touserdata(L, RANGE_STATE);
+    MDBX_val bound      = {0};
+    MDBX_val k          = {0};
+    MDBX_val v          = {0};
+    int rc              = 0;
+
+    if (r->done) {
+        return 0;
+    } else if (r->limit > 0 && r->count >= r->limit) {
+        r->done = 1;
+        return 0;
+    }
+
+    do {
+        if (!r->started) {
+            r->started = 1;
+            rc         = range_seek(L, cur, r, &k, &v);
+        } else {
+            rc = mdbx_cursor_get(cur->cur, &k, &v,
+                                 (r->reverse) ? MDBX_PREV : MDBX_NEXT);
+        }
+
+        if (rc) {
+            r->done = 1;
+            if (rc == MDBX_NOTFOUND) {
+                return 0;
+            }
+            lmdbx_pusherror(L, rc);
+            return lua_error(L);
+        }
+
+        // check the opposite bound
+        if (range_toval(L, (r->reverse) ? RANGE_START : RANGE_STOP,
+                        &bound)) {
+            int cmp = mdbx_cmp(mdbx_cursor_txn(cur->cur),
+                               mdbx_cursor_dbi(cur->cur), &k, &bound);
+
+            if (r->reverse) {
+                cmp = -cmp;
+            }
+            if (cmp > 0 ||
+                (cmp == 0 &&
+                 !((r->reverse) ? r->start_inclusive : r->stop_inclusive))) {
+                r->done = 1;
+                return 0;
+            }
+        }
+        // skip the values that do not match the filter in this loop
+    } while (!range_match(L, cur, r, &v, &rc) && rc == MDBX_SUCCESS);
+
+    if (rc || (rc = pushkv(L, cur, &k, &v))) {
+        r->done = 1;
+        lmdbx_pusherror(L, rc);
+        return lua_error(L);
+    }
+
+    r->count++;
+    return 2;
+}
+
+int lmdbx_cursor_range_lua(lua_State *L)
+{
+    lmdbx_cursor_t *cur = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
+    range_t *r          = NULL;
+    unsigned flags      = 0;
+    unsigned state      = 0;
+    int rc              = 0;
+
+    // cur:range([start [, stop [, opts]]])
+    // opts.filter is evaluated against the values in C, see filter.c
+    if (!lua_isnoneornil(L, 4)) {
+        luaL_checktype(L, 4, LUA_TTABLE);
+    }
+    lua_settop(L, 4);
+    // the bounds are kept as strings
+    for (int idx = 2; idx <= 3; idx++) {
+        lmdbx_topacked(L, idx, INTKEY(cur));
+        lauxh_optlstring(L, idx, NULL, NULL);
+    }
+
+    rc = mdbx_dbi_flags_ex(mdbx_cursor_txn(cur->cur),
+                           mdbx_cursor_dbi(cur->cur), &flags, &state);
+    if (rc) {
+        lua_pushnil(L);
+        lmdbx_pusherror(L, rc);
+        return 2;
+    }
+
+    lua_pushvalue(L, lua_upvalueindex(1));
+    lua_pushvalue(L, 1);
+    lua_pushvalue(L, 2);
+    lua_pushvalue(L, 3);
+    r  = lua_newuserdata(L, sizeof(range_t));
+    *r = (range_t){
+        .reverse         = 0,
+        .start_inclusive = 1,
+        .stop_inclusive  = 0,
+        .dupsort         = (flags & MDBX_DUPSORT) != 0,
+        .limit           = 0,
+        .filter          = NULL,
+    };
+    lua_pushnil(L);
+    if (lua_istable(L, 4)) {
+        r->reverse         = lmdbx_optboolfield(L, 4, "reverse", 0);
+        r->start_inclusive = lmdbx_optboolfield(L, 4, "start_inclusive", 1);
+        r->stop_inclusive  = lmdbx_optboolfield(L, 4, "stop_inclusive", 0);
+        r->limit           = lmdbx_optintfield(L, 4, "limit", 0);
+        lua_getfield(L, 4, "filter");
+        if (!lua_isnil(L, -1)) {
+            // the compiled filter is kept as the upvalue
+            r->filter = lmdbx_filter_check(L, -1, 4);
+            lua_replace(L, -3);
+        }
+        lua_pop(L, 1);
+    }
+    lua_pushcclosure(L, range_next_lua, 6);
+
+    return 1;
+}
+
+static int range_lua(lua_State *L)
+{
+    return lmdbx_cursor_range_lua(L);
+}
+
+int lmdbx_cursor_range_prefix_lua(lua_State *L)
+{
+    size_t len    = 0;
+    const char *s = NULL;
+
+    // cur:range_prefix(prefix [, opts])
+    // iterate over the keys that start with the prefix
+    lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
+    s = lauxh_checklstring(L, 2, &len);
+    lua_settop(L, 3);
+    lmdbx_pushstrinc(L, s, len);
+    lua_insert(L, 3);
+    return lmdbx_cursor_range_lua(L);
+}
+
+static int range_prefix_lua(lua_State *L)
+{
+    return lmdbx_cursor_range_prefix_lua(L);
+}
+
+static int aggregate_lua(lua_State *L)
+{
+    return lmdbx_cursor_aggregate_lua(L);
+}
+
 static int copy_lua(lua_State *L)
 {
     lmdbx_cursor_t *cur = lauxh_checkudata(L, 1, LMDBX_CURSOR_MT);
     lmdbx_cursor_t *dst = lua_newuserdata(L, sizeof(lmdbx_cursor_t));
     int rc              = 0;
 
-    dst->txn_ref = LUA_NOREF;
-    dst->cur     = mdbx_cursor_create(NULL);
+    dst->txn_ref  = LUA_NOREF;
+    dst->txn      = cur->txn;
+    dst->viewmode = cur->viewmode;
+    dst->flags    = cur->flags;
+    dst->keysize  = cur->keysize;
+    dst->datasize = cur->datasize;
+    dst->compress = cur->compress;
+    dst->batch    = NULL;
+    dst->nbatch   = 0;
+    dst->cur      = mdbx_cursor_create(NULL);
     if (!dst->cur) {
         lua_pushnil(L);
         lmdbx_pusherror(L, MDBX_ENOMEM);
@@ -499,6 +1559,7 @@ static int renew_lua(lua_State *L)
     lua_settop(L, 2);
     lauxh_unref(L, cur->txn_ref);
     cur->txn_ref = lauxh_ref(L);
+    cur->txn     = txn;
     lua_pushboolean(L, 1);
 
     return 1;
@@ -512,6 +1573,12 @@ static int close_lua(lua_State *L)
         mdbx_cursor_close(cur->cur);
         cur->cur     = NULL;
         cur->txn_ref = lauxh_unref(L, cur->txn_ref);
+        cur->txn     = NULL;
+    }
+    if (cur->batch) {
+        free(cur->batch);
+        cur->batch  = NULL;
+        cur->nbatch = 0;
     }
     return 0;
 }
@@ -549,7 +1616,15 @@ int lmdbx_cursor_open_lua(lua_State *L)
     }
     lauxh_setmetatable(L, LMDBX_CURSOR_MT);
     lauxh_pushref(L, dbh->txn_ref);
-    cur->txn_ref = lauxh_ref(L);
+    cur->txn_ref  = lauxh_ref(L);
+    cur->txn      = dbh->txn;
+    cur->viewmode = dbh->viewmode;
+    cur->flags    = dbh->dbi->flags;
+    cur->keysize  = dbh->dbi->keysize;
+    cur->datasize = dbh->dbi->datasize;
+    cur->compress = dbh->dbi->compress;
+    cur->batch    = NULL;
+    cur->nbatch   = 0;
 
     return 1;
 }
@@ -563,6 +1638,7 @@ void lmdbx_cursor_init(lua_State *L, int errno_ref)
     };
     struct luaL_Reg method[] = {
         {"txn",               txn_lua              },
+        {"viewmode",          viewmode_lua         },
         {"close",             close_lua            },
         {"renew",             renew_lua            },
         {"copy",              copy_lua             },
@@ -583,8 +1659,22 @@ void lmdbx_cursor_init(lua_State *L, int errno_ref)
         {"get_prev_dup",      get_prev_dup_lua     }, // helper func
         {"get_prev_nodup",    get_prev_nodup_lua   }, // helper func
         {"get",               get_lua              },
+        {"get_obj",           get_obj_lua          },
+        {"get_multiple",      get_multiple_lua     },
+        {"next_multiple",     next_multiple_lua    },
+        {"prev_multiple",     prev_multiple_lua    },
         {"get_batch",         get_batch_lua        },
+        {"project",           project_lua          },
+        {"join_batch",        join_batch_lua       },
+        {"position_token",    position_token_lua   },
+        {"resume",            resume_lua           },
+        {"get_batch_list",    get_batch_list_lua   },
+        {"range",             range_lua            },
+        {"range_prefix",      range_prefix_lua     },
+        {"aggregate",         aggregate_lua        },
         {"put",               put_lua              },
+        {"put_obj",           put_obj_lua          },
+        {"put_multiple",      put_multiple_lua     },
         {"del",               del_lua              },
         {"count",             count_lua            },
         {"eof",               eof_lua              },
@@ -21,6 +21,8 @@
  **/
 
 #include "lmdbx.h"
+#include <limits.h>
+#include <stdlib.h>
 
 // TODO: mdbx_get_attr
 // TODO: mdbx_set_attr
@@ -36,6 +38,88 @@ static inline MDBX_dbi GET_DBI(lmdbx_dbh_t *dbh)
     return (dbh->dbi) ? dbh->dbi->dbi : 0;
 }
 
+static inline int INTKEY(lmdbx_dbh_t *dbh)
+{
+    return LMDBX_INTKEY(dbh->dbi);
+}
+
+static inline int INTDUP(lmdbx_dbh_t *dbh)
+{
+    return LMDBX_INTDUP(dbh->dbi);
+}
+
+static inline void pushkey(lua_State *L, lmdbx_dbh_t *dbh, MDBX_val *k)
+{
+    lmdbx_pushval(L, dbh->viewmode, dbh->txn_ref, dbh->txn, INTKEY(dbh), k);
+}
+
+// returns MDBX_CORRUPTED without pushing a value if the value cannot be
+// decompressed.
+static inline int pushval(lua_State *L, lmdbx_dbh_t *dbh, MDBX_val *v)
+{
+    if (dbh->dbi->compress.enabled) {
+        return lmdbx_compress_pushval(L, dbh->viewmode, dbh->txn_ref,
+                                      dbh->txn, v);
+    }
+    lmdbx_pushval(L, dbh->viewmode, dbh->txn_ref, dbh->txn, INTDUP(dbh), v);
+    return MDBX_SUCCESS;
+}
+
+// compress the value if the database enables the compression, and push the
+// buffer of the value onto the stack.
+static inline void compressval(lua_State *L, lmdbx_dbh_t *dbh, MDBX_val *v)
+{
+    if (dbh->dbi->compress.enabled) {
+        lmdbx_compress_encode(L, dbh->dbi->compress.threshold, v);
+        return;
+    }
+    lua_pushnil(L);
+}
+
+// decompress the value if the database enables the compression, and push
+// the buffer of the value, or nil if not decompressed, onto the stack.
+static inline int decompressval(lua_State *L, lmdbx_dbh_t *dbh, MDBX_val *v)
+{
+    if (dbh->dbi->compress.enabled) {
+        return lmdbx_compress_decode(L, v);
+    }
+    lua_pushnil(L);
+    return MDBX_SUCCESS;
+}
+
+// get the cached cursor, it is reopened if the transaction has been renewed,
+// reset or terminated since it was opened.
+static int getcursor(lmdbx_dbh_t *dbh, MDBX_cursor **cur)
+{
+    if (dbh->cur && dbh->cur_epoch != dbh->txn->epoch) {
+        mdbx_cursor_close(dbh->cur);
+        dbh->cur = NULL;
+    }
+    if (!dbh->cur) {
+        int rc = mdbx_cursor_open(GET_TXN(dbh), GET_DBI(dbh), &dbh->cur);
+        if (rc) {
+            dbh->cur = NULL;
+            return rc;
+        }
+        dbh->cur_epoch = dbh->txn->epoch;
+    }
+    *cur = dbh->cur;
+    return 0;
+}
+
+static int viewmode_lua(lua_State *L)
+{
+    lmdbx_dbh_t *dbh = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
+    int enabled      = dbh->viewmode;
+
+    // dbh:viewmode([enabled]) returns the previous mode
+    if (!lua_isnoneornil(L, 2)) {
+        dbh->viewmode = lauxh_checkboolean(L, 2);
+    }
+    lua_pushboolean(L, enabled);
+    return 1;
+}
+
 static int sequence_lua(lua_State *L)
 {
     lmdbx_dbh_t *dbh = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
@@ -54,24 +138,23 @@ static int sequence_lua(lua_State *L)
 
 static int estimate_range_lua(lua_State *L)
 {
-    lmdbx_dbh_t *dbh      = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
-    size_t begin_klen     = 0;
-    const char *begin_key = lauxh_optlstring(L, 2, NULL, &begin_klen);
-    size_t end_klen       = 0;
-    const char *end_key   = lauxh_optlstring(L, 3, NULL, &end_klen);
-    size_t begin_vlen     = 0;
-    const char *begin_val = lauxh_optlstring(L, 4, NULL, &begin_vlen);
-    size_t end_vlen       = 0;
-    const char *end_val   = lauxh_optlstring(L, 5, NULL, &end_vlen);
-    MDBX_val begin_k = {.iov_base = (void *)begin_key, .iov_len = begin_klen};
-    MDBX_val begin_v = {.iov_base = (void *)begin_val, .iov_len = begin_vlen};
-    MDBX_val end_k   = {.iov_base = (void *)end_key, .iov_len = end_klen};
-    MDBX_val end_v   = {.iov_base = (void *)end_val, .iov_len = end_vlen};
+    lmdbx_dbh_t *dbh         = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
+    lmdbx_intval_t buf[4]    = {0};
+    MDBX_val begin_k         = {0};
+    MDBX_val end_k           = {0};
+    MDBX_val begin_v         = {0};
+    MDBX_val end_v           = {0};
     ptrdiff_t distance_items = 0;
-    int rc                   = mdbx_estimate_range(
-        GET_TXN(dbh), GET_DBI(dbh), (begin_klen) ? &begin_k : NULL,
-        (begin_vlen) ? &begin_v : NULL, (end_klen) ? &end_k : NULL,
-        (end_vlen) ? &end_v : NULL, &distance_items);
+    int rc                   = 0;
+
+    lmdbx_optval(L, 2, INTKEY(dbh), &buf[0], &begin_k);
+    lmdbx_optval(L, 3, INTKEY(dbh), &buf[1], &end_k);
+    lmdbx_optval(L, 4, INTDUP(dbh), &buf[2], &begin_v);
+    lmdbx_optval(L, 5, INTDUP(dbh), &buf[3], &end_v);
+    rc = mdbx_estimate_range(
+        GET_TXN(dbh), GET_DBI(dbh), (begin_k.iov_len) ? &begin_k : NULL,
+        (begin_v.iov_len) ? &begin_v : NULL, (end_k.iov_len) ? &end_k : NULL,
+        (end_v.iov_len) ? &end_v : NULL, &distance_items);
 
     if (rc) {
         lua_pushnil(L);
@@ -82,6 +165,205 @@ static int estimate_range_lua(lua_State *L)
     return 1;
 }
 
+// maximum length of the keys generated by the bisection
+#define SPLIT_MAXKEY  255
+#define SPLIT_MAXITER 64
+
+// set mid to the middle of lo and hi. the keys are compared as unsigned
+// integers if isint is true, or as big-endian numbers padded with 0x00.
+static void bisect_key(const MDBX_val *lo, const MDBX_val *hi, int isint,
+                       uint8_t *buf, MDBX_val *mid)
+{
+    const uint8_t *a = lo->iov_base;
+    const uint8_t *b = hi->iov_base;
+    size_t len       = (lo->iov_len > hi->iov_len) ? lo->iov_len : hi->iov_len;
+    unsigned carry   = 0;
+
+    if (isint) {
+        lmdbx_intval_t x = {0};
+        lmdbx_intval_t y = {0};
+
+        // the smaller key is 0 if it is empty
+        memcpy(&x, a, (lo->iov_len < sizeof(x)) ? lo->iov_len : sizeof(x));
+        memcpy(&y, b, (hi->iov_len < sizeof(y)) ? hi->iov_len : sizeof(y));
+        if (hi->iov_len == sizeof(uint32_t)) {
+            x.u32 += (y.u32 - x.u32) / 2;
+        } else {
+            x.u64 += (y.u64 - x.u64) / 2;
+        }
+        len = (hi->iov_len < sizeof(x)) ? hi->iov_len : sizeof(x);
+        memcpy(buf, &x, len);
+        *mid = (MDBX_val){.iov_base = buf, .iov_len = len};
+        return;
+    }
+
+    // add a byte to split the adjacent keys
+    if (++len > SPLIT_MAXKEY) {
+        len = SPLIT_MAXKEY;
+    }
+    for (size_t i = len; i-- > 0;) {
+        carry += (i < lo->iov_len) ? a[i] : 0;
+        carry += (i < hi->iov_len) ? b[i] : 0;
+        buf[i] = carry & 0xff;
+        carry >>= 8;
+    }
+    for (size_t i = 0; i < len; i++) {
+        unsigned lsb = buf[i] & 1;
+        buf[i]       = (buf[i] >> 1) | (carry << 7);
+        carry        = lsb;
+    }
+    *mid = (MDBX_val){.iov_base = buf, .iov_len = len};
+}
+
+static int split_range_lua(lua_State *L)
+{
+    lmdbx_dbh_t *dbh             = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
+    lua_Integer n                = lauxh_checkinteger(L, 4);
+    MDBX_txn *txn                = GET_TXN(dbh);
+    MDBX_dbi dbi                 = GET_DBI(dbh);
+    MDBX_val bounds[2]           = {0};
+    MDBX_val *start              = NULL;
+    MDBX_val *stop               = NULL;
+    MDBX_val last                = {0};
+    MDBX_val prev                = {0};
+    MDBX_val v                   = {0};
+    MDBX_cursor *cur             = NULL;
+    uint8_t buf[3][SPLIT_MAXKEY] = {0};
+    ptrdiff_t total              = 0;
+    int nsplit                   = 0;
+    int rc                       = 0;
+
+    // dbh:split_range(start, stop, n)
+    // returns up to n - 1 keys that split the range [start, stop) into n
+    // ranges of roughly equal number of items. the keys are found by the
+    // bisection with mdbx_estimate_range.
+    if (n < 1) {
+        lauxh_argerror(L, 4, "n must be greater than 0");
+    }
+    lua_settop(L, 3);
+    for (int i = 0; i < 2; i++) {
+        lmdbx_topacked(L, i + 2, INTKEY(dbh));
+        if (!lua_isnil(L, i + 2)) {
+            bounds[i].iov_base =
+                (void *)lauxh_checklstring(L, i + 2, &bounds[i].iov_len);
+        }
+    }
+    start = (lua_isnil(L, 2)) ? NULL : &bounds[0];
+    stop  = (lua_isnil(L, 3)) ? NULL : &bounds[1];
+
+    if ((rc = getcursor(dbh, &cur)) ||
+        (rc = mdbx_estimate_range(txn, dbi, start, NULL, stop, NULL,
+                                  &total))) {
+        goto FAIL;
+    } else if (stop) {
+        last = *stop;
+    } else if ((rc = mdbx_cursor_get(cur, &last, &v, MDBX_LAST))) {
+        if (rc != MDBX_NOTFOUND) {
+            goto FAIL;
+        }
+        // the database is empty
+        total = 0;
+    }
+
+    // the range cannot be split into more ranges than its items
+    if (n > total) {
+        n = (total > 1) ? total : 1;
+    }
+    if (n > INT_MAX) {
+        n = INT_MAX;
+    }
+    lua_createtable(L, (int)n - 1, 0);
+    for (lua_Integer i = 1; i < n && total > 0; i++) {
+        ptrdiff_t target = (ptrdiff_t)((double)total * i / n);
+        MDBX_val lo      = (start) ? *start : (MDBX_val){0};
+        MDBX_val hi      = last;
+        MDBX_val k       = {0};
+
+        for (int iter = 0; iter < SPLIT_MAXITER; iter++) {
+            ptrdiff_t d  = 0;
+            MDBX_val mid = {0};
+
+            bisect_key(&lo, &hi, INTKEY(dbh), buf[2], &mid);
+            if (mid.iov_len == lo.iov_len &&
+                memcmp(mid.iov_base, lo.iov_base, lo.iov_len) == 0) {
+                // no more keys between lo and hi
+                break;
+            } else if ((rc = mdbx_estimate_range(txn, dbi, start, NULL, &mid,
+                                                 NULL, &d))) {
+                goto FAIL;
+            }
+            // keep the smallest key that reaches the target in hi
+            if (d < target) {
+                memcpy(buf[0], mid.iov_base, mid.iov_len);
+                lo = (MDBX_val){.iov_base = buf[0], .iov_len = mid.iov_len};
+            } else {
+                memcpy(buf[1], mid.iov_base, mid.iov_len);
+                hi = (MDBX_val){.iov_base = buf[1], .iov_len = mid.iov_len};
+                if (d == target) {
+                    break;
+                }
+            }
+        }
+
+        // use the actual key as the split key
+        k  = hi;
+        rc = mdbx_cursor_get(cur, &k, &v, MDBX_SET_RANGE);
+        if (rc == MDBX_NOTFOUND) {
+            break;
+        } else if (rc) {
+            goto FAIL;
+        } else if (stop && mdbx_cmp(txn, dbi, &k, stop) >= 0) {
+            break;
+        } else if ((start && mdbx_cmp(txn, dbi, &k, start) <= 0) ||
+                   (prev.iov_base && mdbx_cmp(txn, dbi, &k, &prev) <= 0)) {
+            // the split keys must be unique and in ascending order
+            continue;
+        }
+        prev = k;
+        lmdbx_pushval(L, 0, LUA_NOREF, NULL, INTKEY(dbh), &k);
+        lua_rawseti(L, -2, ++nsplit);
+    }
+    return 1;
+
+FAIL:
+    lua_pushnil(L);
+    lmdbx_pusherror(L, rc);
+    return 2;
+}
+
+static int range_lua(lua_State *L)
+{
+    // open a new cursor and replace the dbh argument with it
+    lua_settop(L, 4);
+    if (lmdbx_cursor_open_lua(L) != 1) {
+        return 2;
+    }
+    lua_replace(L, 1);
+    return lmdbx_cursor_range_lua(L);
+}
+
+static int range_prefix_lua(lua_State *L)
+{
+    // open a new cursor and replace the dbh argument with it
+    lua_settop(L, 3);
+    if (lmdbx_cursor_open_lua(L) != 1) {
+        return 2;
+    }
+    lua_replace(L, 1);
+    return lmdbx_cursor_range_prefix_lua(L);
+}
+
+static int aggregate_lua(lua_State *L)
+{
+    // open a new cursor and replace the dbh argument with it
+    lua_settop(L, 4);
+    if (lmdbx_cursor_open_lua(L) != 1) {
+        return 2;
+    }
+    lua_replace(L, 1);
+    return lmdbx_cursor_aggregate_lua(L);
+}
+
 static int cursor_open_lua(lua_State *L)
 {
     return lmdbx_cursor_open_lua(L);
@@ -89,14 +371,17 @@ static int cursor_open_lua(lua_State *L)
 
 static int del_lua(lua_State *L)
 {
-    lmdbx_dbh_t *dbh = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
-    size_t klen      = 0;
-    const char *key  = lauxh_checklstring(L, 2, &klen);
-    size_t vlen      = 0;
-    const char *val  = lauxh_optlstring(L, 3, NULL, &vlen);
-    MDBX_val k       = {.iov_base = (void *)key, .iov_len = klen};
-    MDBX_val v       = {.iov_base = (void *)val, .iov_len = vlen};
-    int rc = mdbx_del(GET_TXN(dbh), GET_DBI(dbh), &k, (val) ? &v : NULL);
+    lmdbx_dbh_t *dbh      = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
+    lmdbx_intval_t buf[2] = {0};
+    MDBX_val k            = {0};
+    MDBX_val v            = {0};
+    int has_val           = 0;
+    int rc                = 0;
+
+    lmdbx_checkval(L, 2, INTKEY(dbh), &buf[0], &k);
+    has_val = lmdbx_optval(L, 3, INTDUP(dbh), &buf[1], &v);
+    dbh->txn->gen++;
+    rc = mdbx_del(GET_TXN(dbh), GET_DBI(dbh), &k, (has_val) ? &v : NULL);
 
     if (rc) {
         lua_pushboolean(L, 0);
@@ -110,31 +395,200 @@ static int del_lua(lua_State *L)
     return 1;
 }
 
-static int replace_lua(lua_State *L)
+// delete the keys in the range [start, stop) with the cursor, up to limit
+// keys if limit is greater than 0. all values of the key are deleted at once.
+// *more is set to 1 if the range still has keys.
+static int cursor_del_range(MDBX_cursor *cur, MDBX_val *start, MDBX_val *stop,
+                            int start_inclusive, int stop_inclusive,
+                            lua_Integer limit, lua_Integer *count, int *more)
+{
+    MDBX_txn *txn    = mdbx_cursor_txn(cur);
+    MDBX_dbi dbi     = mdbx_cursor_dbi(cur);
+    lua_Integer nkey = 0;
+    MDBX_val k       = {0};
+    MDBX_val v       = {0};
+    int rc           = 0;
+
+    if (!start) {
+        rc = mdbx_cursor_get(cur, &k, &v, MDBX_FIRST);
+    } else {
+        k  = *start;
+        rc = mdbx_cursor_get(cur, &k, &v, MDBX_SET_RANGE);
+        if (rc == MDBX_SUCCESS && !start_inclusive &&
+            mdbx_cmp(txn, dbi, &k, start) == 0) {
+            rc = mdbx_cursor_get(cur, &k, &v, MDBX_NEXT_NODUP);
+        }
+    }
+
+    *more = 0;
+    while (rc == MDBX_SUCCESS) {
+        size_t n = 0;
+
+        if (stop) {
+            int cmp = mdbx_cmp(txn, dbi, &k, stop);
+            if (cmp > 0 || (cmp == 0 && !stop_inclusive)) {
+                break;
+            }
+        }
+        if (limit > 0 && nkey >= limit) {
+            *more = 1;
+            break;
+        } else if ((rc = mdbx_cursor_count(cur, &n)) ||
+                   (rc = mdbx_cursor_del(cur, MDBX_ALLDUPS))) {
+            return rc;
+        }
+        nkey++;
+        *count += n;
+        // the cursor points to the next item after the deletion
+        rc = mdbx_cursor_get(cur, &k, &v, MDBX_NEXT);
+    }
+
+    return (rc == MDBX_NOTFOUND) ? MDBX_SUCCESS : rc;
+}
+
+static int del_range_lua(lua_State *L)
+{
+    lmdbx_dbh_t *dbh    = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
+    MDBX_val bounds[2]  = {0};
+    MDBX_val *start     = NULL;
+    MDBX_val *stop      = NULL;
+    int start_inclusive = 1;
+    int stop_inclusive  = 0;
+    lua_Integer limit   = 0;
+    lua_Integer count   = 0;
+    MDBX_cursor *cur    = NULL;
+    int more            = 0;
+    int rc              = 0;
+
+    // dbh:del_range([start [, stop [, opts]]])
+    // delete the keys in the range in the C loop. opts.limit is the maximum
+    // number of keys to delete, so that a large range can be deleted across
+    // multiple write transactions. returns the number of deleted items and
+    // whether the range still has keys.
+    if (!lua_isnoneornil(L, 4)) {
+        luaL_checktype(L, 4, LUA_TTABLE);
+        start_inclusive = lmdbx_optboolfield(L, 4, "start_inclusive", 1);
+        stop_inclusive  = lmdbx_optboolfield(L, 4, "stop_inclusive", 0);
+        limit           = lmdbx_optintfield(L, 4, "limit", 0);
+    }
+    lua_settop(L, 3);
+    for (int i = 0; i < 2; i++) {
+        lmdbx_topacked(L, i + 2, INTKEY(dbh));
+        if (!lua_isnil(L, i + 2)) {
+            bounds[i].iov_base =
+                (void *)lauxh_checklstring(L, i + 2, &bounds[i].iov_len);
+        }
+    }
+    start = (lua_isnil(L, 2)) ? NULL : &bounds[0];
+    stop  = (lua_isnil(L, 3)) ? NULL : &bounds[1];
+
+    if ((rc = getcursor(dbh, &cur)) == MDBX_SUCCESS) {
+        dbh->txn->gen++;
+        rc = cursor_del_range(cur, start, stop, start_inclusive,
+                              stop_inclusive, limit, &count, &more);
+    }
+    if (rc) {
+        lua_pushnil(L);
+        lmdbx_pusherror(L, rc);
+        lua_pushinteger(L, count);
+        return 3;
+    }
+    lua_pushinteger(L, count);
+    lua_pushboolean(L, more);
+    return 2;
+}
+
+static int del_prefix_lua(lua_State *L)
+{
+    size_t len    = 0;
+    const char *s = NULL;
+
+    // dbh:del_prefix(prefix [, opts])
+    // delete the keys that start with the prefix
+    lauxh_checkudata(L, 1, LMDBX_DBH_MT);
+    s = lauxh_checklstring(L, 2, &len);
+    lua_settop(L, 3);
+    lmdbx_pushstrinc(L, s, len);
+    lua_insert(L, 3);
+    return del_range_lua(L);
+}
+
+// copy the old value into the buffer of dbh since the page that holds it
+// will be overwritten.
+static int preserve_old(void *ctx, MDBX_val *target, const void *src,
+                        size_t bytes)
+{
+    lmdbx_dbh_t *dbh = ctx;
+
+    if (bytes > dbh->bufsize) {
+        char *buf = realloc(dbh->buf, bytes);
+        if (!buf) {
+            return MDBX_ENOMEM;
+        }
+        dbh->buf     = buf;
+        dbh->bufsize = bytes;
+    }
+    if (bytes) {
+        memcpy(dbh->buf, src, bytes);
+    }
+    target->iov_base = dbh->buf;
+    target->iov_len  = bytes;
+    return MDBX_SUCCESS;
+}
+
+static int discard_old(void *ctx, MDBX_val *target, const void *src,
+                       size_t bytes)
+{
+    (void)ctx;
+    (void)src;
+    (void)bytes;
+    target->iov_base = NULL;
+    target->iov_len  = 0;
+    return MDBX_SUCCESS;
+}
+
+// buf must have 3 elements to hold the integer key, value and old value.
+static int replace(lua_State *L, MDBX_preserve_func preserver,
+                   lmdbx_intval_t *buf, MDBX_val *old)
 {
     lmdbx_dbh_t *dbh  = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
-    size_t klen       = 0;
-    const char *key   = lauxh_checklstring(L, 2, &klen);
-    size_t vlen       = 0;
-    const char *val   = lauxh_optlstring(L, 3, NULL, &vlen);
-    size_t olen       = 0;
-    const char *oval  = lauxh_optlstring(L, 4, NULL, &olen);
     lua_Integer flags = lmdbx_checkflags(L, 5);
-    MDBX_val k        = {.iov_base = (void *)key, .iov_len = klen};
-    MDBX_val v        = {.iov_base = (void *)val, .iov_len = vlen};
-    MDBX_val old      = {.iov_base = (void *)oval, .iov_len = olen};
-    MDBX_val *new     = (val) ? &v : NULL;
-    int rc = mdbx_replace(GET_TXN(dbh), GET_DBI(dbh), &k, new, &old, flags);
+    MDBX_val k        = {0};
+    MDBX_val v        = {0};
+    MDBX_val *new     = NULL;
+
+    lmdbx_checkval(L, 2, INTKEY(dbh), &buf[0], &k);
+    if (lmdbx_optval(L, 3, INTDUP(dbh), &buf[1], &v)) {
+        new = &v;
+        compressval(L, dbh, new);
+    }
+    // the old value is preserved by the preserver only if it is placed on a
+    // dirty page, otherwise it refers to the value in the memory map.
+    lmdbx_optval(L, 4, INTDUP(dbh), &buf[2], old);
+    dbh->txn->gen++;
+    return mdbx_replace_ex(GET_TXN(dbh), GET_DBI(dbh), &k, new, old, flags,
+                           preserver, dbh);
+}
 
-    if (rc == MDBX_RESULT_TRUE) {
-        // the buffer passed in is too small
-        old.iov_base = alloca(old.iov_len);
-        rc = mdbx_replace(GET_TXN(dbh), GET_DBI(dbh), &k, new, &old, flags);
+static int replace_lua(lua_State *L)
+{
+    lmdbx_dbh_t *dbh      = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
+    lmdbx_intval_t buf[3] = {0};
+    MDBX_val old          = {0};
+    int rc                = replace(L, preserve_old, buf, &old);
+
+    // the old value may be placed in the buffer of dbh, so it cannot be
+    // pushed as a view
+    if (rc == MDBX_SUCCESS) {
+        if (dbh->dbi->compress.enabled) {
+            rc = lmdbx_compress_pushval(L, 0, LUA_NOREF, NULL, &old);
+        } else {
+            lmdbx_pushval(L, 0, LUA_NOREF, NULL, INTDUP(dbh), &old);
+        }
     }
 
     switch (rc) {
     case MDBX_SUCCESS:
-        lua_pushlstring(L, old.iov_base, old.iov_len);
         return 1;
 
     default:
@@ -147,21 +601,325 @@ static int replace_lua(lua_State *L)
     }
 }
 
+static int op_replace_lua(lua_State *L)
+{
+    lmdbx_intval_t buf[3] = {0};
+    MDBX_val old          = {0};
+    int rc                = replace(L, discard_old, buf, &old);
+
+    // txn:op_replace(key, val [, old [, ...flags]])
+    // replace the value without returning the old value
+    if (rc) {
+        lua_pushboolean(L, 0);
+        if (rc == MDBX_NOTFOUND) {
+            return 1;
+        }
+        lmdbx_pusherror(L, rc);
+        return 2;
+    }
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+static int reserve_lua(lua_State *L)
+{
+    lmdbx_dbh_t *dbh   = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
+    lmdbx_intval_t buf = {0};
+    MDBX_val k         = {0};
+    lua_Integer size   = lauxh_checkinteger(L, 3);
+    lua_Integer flags  = lmdbx_checkflags(L, 4);
+    MDBX_val v         = {.iov_base = NULL, .iov_len = size};
+    int rc             = 0;
+
+    // dbh:reserve(key, size [, ...flags])
+    lmdbx_checkval(L, 2, INTKEY(dbh), &buf, &k);
+    if (size < 0) {
+        lauxh_argerror(L, 3, "size must be greater than or equal to 0");
+    } else if (dbh->dbi->compress.enabled) {
+        // reserve the space for the header of the uncompressed value
+        v.iov_len++;
+    }
+    dbh->txn->gen++;
+    rc = mdbx_put(GET_TXN(dbh), GET_DBI(dbh), &k, &v, flags | MDBX_RESERVE);
+    if (rc) {
+        lua_pushnil(L);
+        lmdbx_pusherror(L, rc);
+        return 2;
+    } else if (dbh->dbi->compress.enabled) {
+        *(char *)v.iov_base = LMDBX_COMPRESS_RAW;
+        v.iov_base          = (char *)v.iov_base + 1;
+        v.iov_len--;
+    }
+
+    // the reserved space is valid until the next update operation
+    lmdbx_view_new(L, dbh->txn_ref, dbh->txn, &v);
+    ((lmdbx_view_t *)lua_touserdata(L, -1))->writable = 1;
+    return 1;
+}
+
+static int put_obj_lua(lua_State *L)
+{
+    lmdbx_dbh_t *dbh   = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
+    lua_Integer flags  = lmdbx_checkflags(L, 4);
+    lmdbx_intval_t buf = {0};
+    MDBX_val k         = {0};
+    MDBX_cursor *cur   = NULL;
+    int rc             = 0;
+
+    // dbh:put_obj(key, obj [, ...flags])
+    lmdbx_checkval(L, 2, INTKEY(dbh), &buf, &k);
+    luaL_checkany(L, 3);
+    lua_settop(L, 3);
+    if ((rc = getcursor(dbh, &cur)) == MDBX_SUCCESS) {
+        dbh->txn->gen++;
+        rc = lmdbx_msgpack_put(L, cur, &k, 3, flags,
+                               dbh->dbi->flags & MDBX_DUPSORT,
+                               &dbh->dbi->compress);
+    }
+
+    if (rc) {
+        lua_pushboolean(L, 0);
+        if (rc == MDBX_NOTFOUND) {
+            return 1;
+        }
+        lmdbx_pusherror(L, rc);
+        return 2;
+    }
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
 static int put_lua(lua_State *L)
+{
+    lmdbx_dbh_t *dbh      = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
+    lua_Integer flags     = lmdbx_checkflags(L, 4);
+    lmdbx_intval_t buf[2] = {0};
+    MDBX_val k            = {0};
+    MDBX_val v            = {0};
+    int rc                = 0;
+
+    lmdbx_checkval(L, 2, INTKEY(dbh), &buf[0], &k);
+    lmdbx_checkval(L, 3, INTDUP(dbh), &buf[1], &v);
+    compressval(L, dbh, &v);
+    dbh->txn->gen++;
+    rc = mdbx_put(GET_TXN(dbh), GET_DBI(dbh), &k, &v, flags);
+
+    if (rc) {
+        lua_pushboolean(L, 0);
+        if (rc == MDBX_NOTFOUND) {
+            return 1;
+        }
+        lmdbx_pusherror(L, rc);
+        return 2;
+    }
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+static inline void check_kvpair(lua_State *L, lmdbx_dbh_t *dbh, int kidx,
+                                int vidx)
+{
+    // integers are stored as the packed string
+    lmdbx_topacked(L, kidx, INTKEY(dbh));
+    lmdbx_topacked(L, vidx, INTDUP(dbh));
+    if (lua_type(L, kidx) != LUA_TSTRING) {
+        lauxh_argerror(L, 2, "key must be string, got %s",
+                       luaL_typename(L, kidx));
+    } else if (lua_type(L, vidx) != LUA_TSTRING) {
+        lauxh_argerror(L, 2, "value must be string, got %s",
+                       luaL_typename(L, vidx));
+    }
+}
+
+static int put_many_lua(lua_State *L)
 {
     lmdbx_dbh_t *dbh  = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
-    size_t klen       = 0;
-    const char *key   = lauxh_checklstring(L, 2, &klen);
-    size_t vlen       = 0;
-    const char *val   = lauxh_checklstring(L, 3, &vlen);
+    int do_sort       = lauxh_optboolean(L, 3, 0);
     lua_Integer flags = lmdbx_checkflags(L, 4);
-    MDBX_val k        = {.iov_base = (void *)key, .iov_len = klen};
-    MDBX_val v        = {.iov_base = (void *)val, .iov_len = vlen};
-    int rc            = mdbx_put(GET_TXN(dbh), GET_DBI(dbh), &k, &v, flags);
+    unsigned dbflags  = 0;
+    unsigned state    = 0;
+    MDBX_cursor *cur  = NULL;
+    MDBX_val *keys    = NULL;
+    MDBX_val *vals    = NULL;
+    size_t *idx       = NULL;
+    MDBX_val maxk     = {0};
+    MDBX_val maxv     = {0};
+    int has_max       = 0;
+    size_t n          = 0;
+    size_t nput       = 0;
+    int rc            = 0;
+
+    // dbh:put_many(src [, sort [, ...flags]])
+    // src is a table of key/value pairs, or an iterator function that
+    // returns key and value until the key is nil
+    if (!lua_isfunction(L, 2)) {
+        luaL_checktype(L, 2, LUA_TTABLE);
+    }
+    lua_settop(L, 3);
+
+    // collect pairs into the anchor table as {k1, v1, k2, v2, ...}
+    lua_newtable(L);
+    if (lua_isfunction(L, 2)) {
+        while (1) {
+            lua_pushvalue(L, 2);
+            lua_call(L, 0, 2);
+            if (lua_isnil(L, -2)) {
+                lua_pop(L, 2);
+                break;
+            }
+            check_kvpair(L, dbh, -2, -1);
+            lua_rawseti(L, 4, n * 2 + 2);
+            lua_rawseti(L, 4, n * 2 + 1);
+            n++;
+        }
+    } else {
+        lua_pushnil(L);
+        while (lua_next(L, 2)) {
+            // check the copies to keep the key for lua_next
+            lua_pushvalue(L, -2);
+            lua_insert(L, -2);
+            check_kvpair(L, dbh, -2, -1);
+            lua_rawseti(L, 4, n * 2 + 2);
+            lua_rawseti(L, 4, n * 2 + 1);
+            n++;
+        }
+    }
+    if (n == 0) {
+        lua_pushinteger(L, 0);
+        return 1;
+    }
+
+    keys = lua_newuserdata(L, (sizeof(MDBX_val) + sizeof(size_t)) * n * 2);
+    vals = keys + n;
+    idx  = (size_t *)(vals + n);
+    for (size_t i = 0; i < n; i++) {
+        lua_rawgeti(L, 4, i * 2 + 1);
+        keys[i].iov_base = (void *)lua_tolstring(L, -1, &keys[i].iov_len);
+        lua_rawgeti(L, 4, i * 2 + 2);
+        vals[i].iov_base = (void *)lua_tolstring(L, -1, &vals[i].iov_len);
+        lua_pop(L, 2);
+        if (dbh->dbi->compress.enabled) {
+            // keep the compressed value in the anchor table
+            lmdbx_compress_encode(L, dbh->dbi->compress.threshold,
+                                  &vals[i]);
+            lua_rawseti(L, 4, i * 2 + 2);
+        }
+        idx[i] = i;
+    }
+    if (do_sort) {
+        lmdbx_sortkeys(GET_TXN(dbh), GET_DBI(dbh), keys, idx, idx + n, n);
+    }
+
+    if ((rc = mdbx_dbi_flags_ex(GET_TXN(dbh), GET_DBI(dbh), &dbflags,
+                                &state)) ||
+        (rc = getcursor(dbh, &cur))) {
+        lua_pushnil(L);
+        lmdbx_pusherror(L, rc);
+        return 2;
+    }
+
+    // the last item of the database is the initial append position
+    rc = mdbx_cursor_get(cur, &maxk, &maxv, MDBX_LAST);
+    if (rc == MDBX_SUCCESS) {
+        // copy it since the page may be changed by the following puts
+        lua_pushlstring(L, maxk.iov_base, maxk.iov_len);
+        maxk.iov_base = (void *)lua_tostring(L, -1);
+        lua_pushlstring(L, maxv.iov_base, maxv.iov_len);
+        maxv.iov_base = (void *)lua_tostring(L, -1);
+        has_max       = 1;
+    } else if (rc != MDBX_NOTFOUND) {
+        lua_pushnil(L);
+        lmdbx_pusherror(L, rc);
+        return 2;
+    }
+
+    dbh->txn->gen++;
+    for (; nput < n; nput++) {
+        MDBX_val *k = &keys[idx[nput]];
+        MDBX_val *v = &vals[idx[nput]];
+        unsigned f  = flags;
+        int cmp     = 1;
+
+        // use the append mode if the item is beyond the last item
+        if (has_max) {
+            cmp = mdbx_cmp(GET_TXN(dbh), GET_DBI(dbh), k, &maxk);
+        }
+        if (cmp > 0) {
+            maxk    = *k;
+            maxv    = *v;
+            has_max = 1;
+            f |= MDBX_APPEND;
+        } else if (cmp == 0 && (dbflags & MDBX_DUPSORT) &&
+                   mdbx_dcmp(GET_TXN(dbh), GET_DBI(dbh), v, &maxv) > 0) {
+            maxv = *v;
+            f |= MDBX_APPENDDUP;
+        }
+
+        if ((rc = mdbx_cursor_put(cur, k, v, f))) {
+            lua_pushnil(L);
+            lmdbx_pusherror(L, rc);
+            lua_pushinteger(L, nput);
+            return 3;
+        }
+    }
+
+    lua_pushinteger(L, nput);
+    return 1;
+}
+
+#define UPSERT_SINGLE 0
+#define UPSERT_MULTI  1
+#define UPSERT_UPDATE 2
+#define UPSERT_INSERT 3
+
+// write the value with a single descent of the cursor.
+// the cursor is positioned by the lookup and then the value is written in
+// place of the current item.
+static int cursor_upsert(MDBX_cursor *cur, MDBX_val *k, MDBX_val *v, int op)
+{
+    MDBX_val ck = *k;
+    MDBX_val cv = {0};
+    int rc      = 0;
+
+    switch (op) {
+    case UPSERT_MULTI:
+        return mdbx_cursor_put(cur, k, v, MDBX_UPSERT);
+
+    case UPSERT_INSERT:
+        return mdbx_cursor_put(cur, k, v, MDBX_NOOVERWRITE);
+
+    default:
+        rc = mdbx_cursor_get(cur, &ck, &cv, MDBX_SET_KEY);
+        if (rc == MDBX_SUCCESS) {
+            // replace all values of the key with a single new value
+            return mdbx_cursor_put(cur, k, v, MDBX_CURRENT | MDBX_ALLDUPS);
+        } else if (rc == MDBX_NOTFOUND && op == UPSERT_SINGLE) {
+            return mdbx_cursor_put(cur, k, v, MDBX_UPSERT);
+        }
+        return rc;
+    }
+}
+
+static int upsert(lua_State *L, int op)
+{
+    lmdbx_dbh_t *dbh      = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
+    lmdbx_intval_t buf[2] = {0};
+    MDBX_val k            = {0};
+    MDBX_val v            = {0};
+    MDBX_cursor *cur      = NULL;
+    int rc                = 0;
+
+    lmdbx_checkval(L, 2, INTKEY(dbh), &buf[0], &k);
+    lmdbx_checkval(L, 3, INTDUP(dbh), &buf[1], &v);
+    compressval(L, dbh, &v);
+    if ((rc = getcursor(dbh, &cur)) == MDBX_SUCCESS) {
+        dbh->txn->gen++;
+        rc = cursor_upsert(cur, &k, &v, op);
+    }
 
     if (rc) {
         lua_pushboolean(L, 0);
-        if (rc == MDBX_NOTFOUND) {
+        if (rc == MDBX_NOTFOUND && op == UPSERT_UPDATE) {
             return 1;
         }
         lmdbx_pusherror(L, rc);
@@ -177,82 +935,215 @@ static int op_update_lua(lua_State *L)
     // txn:op_update(key, val, old)
     // update one multi-value entry
     if (lua_gettop(L) > 3) {
-        int rc = 0;
-
         lua_settop(L, 4);
         lua_pushinteger(L, MDBX_CURRENT | MDBX_NOOVERWRITE);
-        rc = replace_lua(L);
-        if (rc <= 1) {
-            lua_pushboolean(L, rc);
-            return 1;
-        }
-        lua_pushboolean(L, 0);
-        lua_replace(L, -(rc + 1));
-        return rc;
+        return op_replace_lua(L);
     }
 
     // txn:op_update(key, val)
     // overwrite by single new value
-    lua_settop(L, 3);
-    lua_pushinteger(L, MDBX_CURRENT | MDBX_ALLDUPS);
-    return put_lua(L);
+    return upsert(L, UPSERT_UPDATE);
 }
 
 static int op_upsert_lua(lua_State *L)
+{
+    // txn:op_upsert(key, val [, multi])
+    if (lauxh_optboolean(L, 4, 0)) {
+        return upsert(L, UPSERT_MULTI);
+    }
+    return upsert(L, UPSERT_SINGLE);
+}
+
+static int op_upsert_many_lua(lua_State *L)
 {
     lmdbx_dbh_t *dbh = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
-    size_t klen      = 0;
-    const char *key  = lauxh_checklstring(L, 2, &klen);
-    size_t vlen      = 0;
-    const char *val  = lauxh_checklstring(L, 3, &vlen);
-    int multi        = lauxh_optboolean(L, 4, 0);
-    MDBX_val k       = {.iov_base = (void *)key, .iov_len = klen};
-    MDBX_val v       = {.iov_base = (void *)val, .iov_len = vlen};
-    MDBX_val nouse   = {.iov_base = (void *)NULL, .iov_len = 0};
+    int multi        = lauxh_optboolean(L, 3, 0);
+    MDBX_cursor *cur = NULL;
+    lua_Integer n    = 0;
     int rc           = 0;
 
-    // txn:op_upsert(key, val [, multi])
-    if (multi) {
-        rc = mdbx_put(GET_TXN(dbh), GET_DBI(dbh), &k, &v, MDBX_UPSERT);
-    } else if (mdbx_get(GET_TXN(dbh), GET_DBI(dbh), &k, &nouse) == 0) {
-        // replace current value
-        rc = mdbx_put(GET_TXN(dbh), GET_DBI(dbh), &k, &v,
-                      MDBX_UPSERT | MDBX_CURRENT | MDBX_ALLDUPS);
+    // txn:op_upsert_many(tbl [, multi])
+    luaL_checktype(L, 2, LUA_TTABLE);
+    lua_settop(L, 2);
+    if ((rc = getcursor(dbh, &cur))) {
+        lua_pushnil(L);
+        lmdbx_pusherror(L, rc);
+        return 2;
+    }
+
+    dbh->txn->gen++;
+    lua_pushnil(L);
+    while (lua_next(L, 2)) {
+        lmdbx_intval_t buf[2] = {0};
+        MDBX_val k            = {0};
+        MDBX_val v            = {0};
+
+        // a numeric key must not be converted in place, or lua_next will
+        // lose the position of the table
+        if (!lmdbx_isval(L, -2, INTKEY(dbh))) {
+            lauxh_argerror(L, 2, "key must be string, got %s",
+                           luaL_typename(L, -2));
+        } else if (!lmdbx_isval(L, -1, INTDUP(dbh))) {
+            lauxh_argerror(L, 2, "value must be string, got %s",
+                           luaL_typename(L, -1));
+        }
+        lmdbx_checkval(L, -2, INTKEY(dbh), &buf[0], &k);
+        lmdbx_checkval(L, -1, INTDUP(dbh), &buf[1], &v);
+        compressval(L, dbh, &v);
+        if ((rc = cursor_upsert(cur, &k, &v,
+                                (multi) ? UPSERT_MULTI : UPSERT_SINGLE))) {
+            lua_pushnil(L);
+            lmdbx_pusherror(L, rc);
+            lua_pushinteger(L, n);
+            return 3;
+        }
+        // keep the key for lua_next
+        lua_settop(L, 3);
+        n++;
+    }
+
+    lua_pushinteger(L, n);
+    return 1;
+}
+
+static int op_insert_lua(lua_State *L)
+{
+    return upsert(L, UPSERT_INSERT);
+}
+
+// add delta to the 8-byte integer value of the key with a single descent of
+// the cursor, or store initial + delta if the key does not exist.
+static int cursor_incr(MDBX_cursor *cur, MDBX_val *k, int64_t delta,
+                       int64_t initial, int64_t *res)
+{
+    MDBX_val ck    = *k;
+    MDBX_val v     = {0};
+    unsigned flags = MDBX_CURRENT;
+    int rc         = mdbx_cursor_get(cur, &ck, &v, MDBX_SET_KEY);
+
+    if (rc == MDBX_NOTFOUND) {
+        *res  = initial;
+        flags = MDBX_NOOVERWRITE;
+    } else if (rc) {
+        return rc;
+    } else if (v.iov_len != sizeof(int64_t)) {
+        return MDBX_BAD_VALSIZE;
     } else {
-        rc = mdbx_put(GET_TXN(dbh), GET_DBI(dbh), &k, &v, MDBX_UPSERT);
+        memcpy(res, v.iov_base, sizeof(int64_t));
     }
+    // wrap around on overflow
+    *res = (int64_t)((uint64_t)*res + (uint64_t)delta);
+    v    = (MDBX_val){.iov_base = res, .iov_len = sizeof(int64_t)};
+    return mdbx_cursor_put(cur, k, &v, flags);
+}
 
+// the counter is stored as a plain 8-byte value in native byte order
+static inline int getincrcursor(lmdbx_dbh_t *dbh, MDBX_cursor **cur)
+{
+    if (dbh->dbi->compress.enabled || (dbh->dbi->flags & MDBX_DUPSORT)) {
+        return MDBX_INCOMPATIBLE;
+    }
+    return getcursor(dbh, cur);
+}
+
+static int incr_lua(lua_State *L)
+{
+    lmdbx_dbh_t *dbh    = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
+    lua_Integer delta   = lauxh_checkinteger(L, 3);
+    lua_Integer initial = lauxh_optinteger(L, 4, 0);
+    lmdbx_intval_t buf  = {0};
+    MDBX_val k          = {0};
+    MDBX_cursor *cur    = NULL;
+    int64_t res         = 0;
+    int rc              = 0;
+
+    // dbh:incr(key, delta [, initial])
+    lmdbx_checkval(L, 2, INTKEY(dbh), &buf, &k);
+    if ((rc = getincrcursor(dbh, &cur)) == MDBX_SUCCESS) {
+        dbh->txn->gen++;
+        rc = cursor_incr(cur, &k, delta, initial, &res);
+    }
     if (rc) {
-        lua_pushboolean(L, 0);
+        lua_pushnil(L);
         lmdbx_pusherror(L, rc);
         return 2;
     }
-    lua_pushboolean(L, 1);
+    lua_pushinteger(L, res);
     return 1;
 }
 
-static int op_insert_lua(lua_State *L)
+static int incr_many_lua(lua_State *L)
 {
-    lua_settop(L, 3);
-    lua_pushinteger(L, MDBX_NOOVERWRITE);
-    return put_lua(L);
+    lmdbx_dbh_t *dbh = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
+    MDBX_cursor *cur = NULL;
+    lua_Integer n    = 0;
+    int rc           = 0;
+
+    // dbh:incr_many(tbl)
+    // tbl is a table of key/delta pairs
+    luaL_checktype(L, 2, LUA_TTABLE);
+    lua_settop(L, 2);
+    if ((rc = getincrcursor(dbh, &cur))) {
+        lua_pushnil(L);
+        lmdbx_pusherror(L, rc);
+        return 2;
+    }
+
+    dbh->txn->gen++;
+    lua_pushnil(L);
+    while (lua_next(L, 2)) {
+        lmdbx_intval_t buf = {0};
+        MDBX_val k         = {0};
+        int64_t res        = 0;
+
+        // a numeric key must not be converted in place, or lua_next will
+        // lose the position of the table
+        if (!lmdbx_isval(L, -2, INTKEY(dbh))) {
+            lauxh_argerror(L, 2, "key must be string, got %s",
+                           luaL_typename(L, -2));
+        } else if (lua_type(L, -1) != LUA_TNUMBER ||
+                   !lmdbx_isinteger(L, -1)) {
+            lauxh_argerror(L, 2, "delta must be integer, got %s",
+                           luaL_typename(L, -1));
+        }
+        lmdbx_checkval(L, -2, INTKEY(dbh), &buf, &k);
+        if ((rc = cursor_incr(cur, &k, lua_tointeger(L, -1), 0, &res))) {
+            lua_pushnil(L);
+            lmdbx_pusherror(L, rc);
+            lua_pushinteger(L, n);
+            return 3;
+        }
+        // keep the key for lua_next
+        lua_settop(L, 3);
+        n++;
+    }
+
+    lua_pushinteger(L, n);
+    return 1;
 }
 
 static int get_equal_or_great_lua(lua_State *L)
 {
-    lmdbx_dbh_t *dbh = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
-    size_t klen      = 0;
-    const char *key  = lauxh_checklstring(L, 2, &klen);
-    MDBX_val k       = {.iov_base = (void *)key, .iov_len = klen};
-    MDBX_val v       = {0};
-    int rc = mdbx_get_equal_or_great(GET_TXN(dbh), GET_DBI(dbh), &k, &v);
+    lmdbx_dbh_t *dbh   = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
+    lmdbx_intval_t buf = {0};
+    MDBX_val k         = {0};
+    MDBX_val v         = {0};
+    int rc             = 0;
 
+    lmdbx_checkval(L, 2, INTKEY(dbh), &buf, &k);
+    rc = mdbx_get_equal_or_great(GET_TXN(dbh), GET_DBI(dbh), &k, &v);
     switch (rc) {
     case MDBX_SUCCESS:
     case MDBX_RESULT_TRUE:
         lua_createtable(L, 0, 2);
-        lauxh_pushlstr2tbl(L, "key", k.iov_base, k.iov_len);
-        lauxh_pushlstr2tbl(L, "data", v.iov_base, v.iov_len);
+        pushkey(L, dbh, &k);
+        lua_setfield(L, -2, "key");
+        if ((rc = pushval(L, dbh, &v))) {
+            lua_pushnil(L);
+            lmdbx_pusherror(L, rc);
+            return 2;
+        }
+        lua_setfield(L, -2, "data");
         return 1;
 
     case MDBX_NOTFOUND:
@@ -265,20 +1156,107 @@ static int get_equal_or_great_lua(lua_State *L)
     }
 }
 
-static int get_lua(lua_State *L)
+static int get_many(lua_State *L, int exists_only)
 {
-    lmdbx_dbh_t *dbh = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
-    size_t klen      = 0;
-    const char *key  = lauxh_checklstring(L, 2, &klen);
-    int do_count     = lauxh_optboolean(L, 3, 0);
-    MDBX_val k       = {.iov_base = (void *)key, .iov_len = klen};
-    MDBX_val v       = {0};
-    size_t count     = 0;
-    int rc           = (do_count) ?
-                           mdbx_get_ex(GET_TXN(dbh), GET_DBI(dbh), &k, &v, &count) :
-                           mdbx_get(GET_TXN(dbh), GET_DBI(dbh), &k, &v);
+    lmdbx_dbh_t *dbh     = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
+    MDBX_cursor *cur     = NULL;
+    MDBX_val *keys       = NULL;
+    size_t *idx          = NULL;
+    lmdbx_intval_t *ikey = NULL;
+    size_t n             = 0;
+    int rc               = 0;
+
+    luaL_checktype(L, 2, LUA_TTABLE);
+    lua_settop(L, 2);
+    n = lmdbx_rawlen(L, 2);
+    if (n == 0) {
+        lua_createtable(L, 0, 0);
+        return 1;
+    }
 
+    // collect keys, then sort their indexes in the database order
+    // integer keys are packed into ikey
+    keys = lua_newuserdata(L, (sizeof(MDBX_val) + sizeof(lmdbx_intval_t) +
+                               sizeof(size_t) * 2) *
+                                  n);
+    ikey = (lmdbx_intval_t *)(keys + n);
+    idx  = (size_t *)(ikey + n);
+    for (size_t i = 0; i < n; i++) {
+        lua_rawgeti(L, 2, i + 1);
+        if (!lmdbx_isval(L, -1, INTKEY(dbh))) {
+            lauxh_argerror(L, 2, "item#%d must be string, got %s",
+                           (int)(i + 1), luaL_typename(L, -1));
+        }
+        // the key string is still referenced by the table
+        lmdbx_checkval(L, -1, INTKEY(dbh), &ikey[i], &keys[i]);
+        lua_pop(L, 1);
+        idx[i] = i;
+    }
+    lmdbx_sortkeys(GET_TXN(dbh), GET_DBI(dbh), keys, idx, idx + n, n);
+
+    rc = getcursor(dbh, &cur);
     if (rc) {
+        lua_pushnil(L);
+        lmdbx_pusherror(L, rc);
+        return 2;
+    }
+
+    // the cursor moves forward only, so that the adjacent keys are looked up
+    // on the already positioned leaf page
+    lua_createtable(L, n, 0);
+    for (size_t i = 0; i < n; i++) {
+        MDBX_val k = keys[idx[i]];
+        MDBX_val v = {0};
+
+        rc = mdbx_cursor_get(cur, &k, &v, MDBX_SET_KEY);
+        if (rc == MDBX_SUCCESS) {
+            if (exists_only) {
+                lua_pushboolean(L, 1);
+            } else if ((rc = pushval(L, dbh, &v))) {
+                lua_pushnil(L);
+                lmdbx_pusherror(L, rc);
+                return 2;
+            }
+        } else if (rc == MDBX_NOTFOUND) {
+            if (!exists_only) {
+                continue;
+            }
+            lua_pushboolean(L, 0);
+        } else {
+            lua_pushnil(L);
+            lmdbx_pusherror(L, rc);
+            return 2;
+        }
+        lua_rawseti(L, -2, idx[i] + 1);
+    }
+
+    return 1;
+}
+
+static int exists_many_lua(lua_State *L)
+{
+    return get_many(L, 1);
+}
+
+static int get_many_lua(lua_State *L)
+{
+    return get_many(L, 0);
+}
+
+static int get_lua(lua_State *L)
+{
+    lmdbx_dbh_t *dbh   = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
+    int do_count       = lauxh_optboolean(L, 3, 0);
+    lmdbx_intval_t buf = {0};
+    MDBX_val k         = {0};
+    MDBX_val v         = {0};
+    size_t count       = 0;
+    int rc             = 0;
+
+    lmdbx_checkval(L, 2, INTKEY(dbh), &buf, &k);
+    rc = (do_count) ? mdbx_get_ex(GET_TXN(dbh), GET_DBI(dbh), &k, &v, &count) :
+                      mdbx_get(GET_TXN(dbh), GET_DBI(dbh), &k, &v);
+    if (rc || (rc = pushval(L, dbh, &v))) {
         if (rc == MDBX_NOTFOUND) {
             return 0;
         }
@@ -286,7 +1264,6 @@ static int get_lua(lua_State *L)
         lmdbx_pusherror(L, rc);
         return 2;
     }
-    lua_pushlstring(L, v.iov_base, v.iov_len);
     if (do_count) {
         lua_pushnil(L);
         lua_pushinteger(L, count);
@@ -295,6 +1272,72 @@ static int get_lua(lua_State *L)
     return 1;
 }
 
+static int get_field_lua(lua_State *L)
+{
+    lmdbx_dbh_t *dbh   = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
+    lmdbx_schema_t *s  = lauxh_checkudata(L, 3, LMDBX_SCHEMA_MT);
+    lmdbx_field_t *f   = lmdbx_schema_checkfield(L, s, 4);
+    lmdbx_intval_t buf = {0};
+    MDBX_val k         = {0};
+    MDBX_val v         = {0};
+    int rc             = 0;
+
+    // dbh:get_field(key, schema, field)
+    // read a field directly from the record in the page of the database
+    lmdbx_checkval(L, 2, INTKEY(dbh), &buf, &k);
+    rc = mdbx_get(GET_TXN(dbh), GET_DBI(dbh), &k, &v);
+    if (rc == MDBX_SUCCESS) {
+        // remove the buffer of the decompressed value after use
+        if ((rc = decompressval(L, dbh, &v)) == MDBX_SUCCESS &&
+            (rc = lmdbx_schema_pushfield(L, f, &v)) == MDBX_SUCCESS) {
+            lua_remove(L, -2);
+        } else {
+            lua_pop(L, 1);
+        }
+    }
+    if (rc) {
+        if (rc == MDBX_NOTFOUND) {
+            return 0;
+        }
+        lua_pushnil(L);
+        lmdbx_pusherror(L, rc);
+        return 2;
+    }
+    return 1;
+}
+
+static int get_obj_lua(lua_State *L)
+{
+    lmdbx_dbh_t *dbh   = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
+    lmdbx_intval_t buf = {0};
+    MDBX_val k         = {0};
+    MDBX_val v         = {0};
+    int rc             = 0;
+
+    // dbh:get_obj(key)
+    // the value is decoded directly from the page of the database
+    lmdbx_checkval(L, 2, INTKEY(dbh), &buf, &k);
+    rc = mdbx_get(GET_TXN(dbh), GET_DBI(dbh), &k, &v);
+    if (rc == MDBX_SUCCESS) {
+        // remove the buffer of the decompressed value after use
+        if ((rc = decompressval(L, dbh, &v)) == MDBX_SUCCESS &&
+            (rc = lmdbx_msgpack_decode(L, &v)) == MDBX_SUCCESS) {
+            lua_remove(L, -2);
+        } else {
+            lua_pop(L, 1);
+        }
+    }
+    if (rc) {
+        if (rc == MDBX_NOTFOUND) {
+            return 0;
+        }
+        lua_pushnil(L);
+        lmdbx_pusherror(L, rc);
+        return 2;
+    }
+    return 1;
+}
+
 static int flags_lua(lua_State *L)
 {
     lmdbx_dbh_t *dbh = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
@@ -393,17 +1436,33 @@ static int stat_lua(lua_State *L)
 static lmdbx_txn_t TXN_NULL = {
     .env_ref = LUA_NOREF,
     .txn     = NULL,
+    .gen     = 0,
+    .epoch   = 0,
 };
 
 static lmdbx_dbi_t DBI_NULL = {
-    .env_ref = LUA_NOREF,
-    .dbi     = 0,
+    .env_ref  = LUA_NOREF,
+    .name_ref = LUA_NOREF,
+    .dbi      = 0,
+    .flags    = 0,
+    .keysize  = 0,
+    .datasize = 0,
+    .compress = {0},
 };
 
 static int close_lua(lua_State *L)
 {
     lmdbx_dbh_t *dbh = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
 
+    if (dbh->cur) {
+        mdbx_cursor_close(dbh->cur);
+        dbh->cur = NULL;
+    }
+    if (dbh->buf) {
+        free(dbh->buf);
+        dbh->buf     = NULL;
+        dbh->bufsize = 0;
+    }
     dbh->dbi_ref = lauxh_unref(L, dbh->dbi_ref);
     dbh->txn_ref = lauxh_unref(L, dbh->txn_ref);
     dbh->dbi     = &DBI_NULL;
@@ -416,7 +1475,13 @@ static int drop_lua(lua_State *L)
 {
     lmdbx_dbh_t *dbh = lauxh_checkudata(L, 1, LMDBX_DBH_MT);
     int del          = lauxh_optboolean(L, 2, 0);
-    int rc           = mdbx_drop(GET_TXN(dbh), GET_DBI(dbh), del);
+    int rc           = 0;
+
+    dbh->txn->gen++;
+    rc = mdbx_drop(GET_TXN(dbh), GET_DBI(dbh), del);
+    if (rc == MDBX_SUCCESS && del) {
+        rc = lmdbx_dbi_delcompress(L, GET_TXN(dbh), dbh->dbi);
+    }
 
     if (rc) {
         lua_pushboolean(L, 0);
@@ -463,10 +1528,15 @@ int lmdbx_dbh_open_lua(lua_State *L)
     lmdbx_dbh_t *dbh = lua_newuserdata(L, sizeof(lmdbx_dbh_t));
 
     lauxh_setmetatable(L, LMDBX_DBH_MT);
-    dbh->dbi_ref = lauxh_refat(L, 1);
-    dbh->txn_ref = lauxh_refat(L, 2);
-    dbh->dbi     = dbi;
-    dbh->txn     = txn;
+    dbh->dbi_ref   = lauxh_refat(L, 1);
+    dbh->txn_ref   = lauxh_refat(L, 2);
+    dbh->dbi       = dbi;
+    dbh->txn       = txn;
+    dbh->viewmode  = 0;
+    dbh->cur       = NULL;
+    dbh->cur_epoch = 0;
+    dbh->buf       = NULL;
+    dbh->bufsize   = 0;
 
     return 1;
 }
@@ -481,21 +1551,39 @@ void lmdbx_dbh_init(lua_State *L, int errno_ref)
     struct luaL_Reg method[] = {
         {"dbi",                dbi_lua               },
         {"txn",                txn_lua               },
+        {"viewmode",           viewmode_lua          },
         {"drop",               drop_lua              },
         {"close",              close_lua             },
         {"stat",               stat_lua              },
         {"dupsort_depthmask",  dupsort_depthmask_lua },
         {"flags",              flags_lua             },
         {"get",                get_lua               },
+        {"get_obj",            get_obj_lua           },
+        {"get_field",          get_field_lua         },
+        {"get_many",           get_many_lua          },
+        {"exists_many",        exists_many_lua       },
         {"get_equal_or_great", get_equal_or_great_lua},
         {"op_insert",          op_insert_lua         }, // helper func
         {"op_upsert",          op_upsert_lua         }, // helper func
+        {"op_upsert_many",     op_upsert_many_lua    }, // helper func
         {"op_update",          op_update_lua         }, // helper func
         {"put",                put_lua               },
+        {"reserve",            reserve_lua           },
+        {"put_obj",            put_obj_lua           },
+        {"put_many",           put_many_lua          },
+        {"incr",               incr_lua              },
+        {"incr_many",          incr_many_lua         },
+        {"op_replace",         op_replace_lua        }, // helper func
         {"replace",            replace_lua           },
         {"del",                del_lua               },
+        {"del_range",          del_range_lua         },
+        {"del_prefix",         del_prefix_lua        },
         {"cursor_open",        cursor_open_lua       },
+        {"range",              range_lua             },
+        {"range_prefix",       range_prefix_lua      },
+        {"aggregate",          aggregate_lua         },
         {"estimate_range",     estimate_range_lua    },
+        {"split_range",        split_range_lua       },
         {"sequence",           sequence_lua          },
         {NULL,                 NULL                  }
     };
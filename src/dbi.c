@@ -71,6 +71,7 @@ static int gc_lua(lua_State *L)
 {
     lmdbx_dbi_t *dbi = lauxh_checkudata(L, 1, LMDBX_DBI_MT);
     lauxh_unref(L, dbi->env_ref);
+    lauxh_unref(L, dbi->name_ref);
     return 0;
 }
 
@@ -81,14 +82,195 @@ static int tostring_lua(lua_State *L)
     return 1;
 }
 
+static MDBX_cmp_func *optcmpfield(lua_State *L, int idx, const char *field)
+{
+    MDBX_cmp_func *cmp = NULL;
+    const char *name   = NULL;
+
+    lua_getfield(L, idx, field);
+    if (!lua_isnil(L, -1)) {
+        if (lua_type(L, -1) != LUA_TSTRING) {
+            lauxh_argerror(L, idx, "%s must be string, got %s", field,
+                           luaL_typename(L, -1));
+        }
+        name = lua_tostring(L, -1);
+        if (!(cmp = lmdbx_cmp_find(name))) {
+            lauxh_argerror(L, idx, "unknown %s comparator: %s", field, name);
+        }
+    }
+    lua_pop(L, 1);
+    return cmp;
+}
+
+// the integer keys and values of a database have the same size, 4 or 8
+// bytes. take the size from the first record so that the numbers are packed
+// to that size, or use 8 bytes if the database is empty.
+static int get_intsize(MDBX_txn *txn, lmdbx_dbi_t *dbi)
+{
+    MDBX_cursor *cur = NULL;
+    MDBX_val k       = {0};
+    MDBX_val v       = {0};
+    int rc           = 0;
+
+    dbi->keysize  = sizeof(uint64_t);
+    dbi->datasize = sizeof(uint64_t);
+    if (!(dbi->flags & (MDBX_INTEGERKEY | MDBX_INTEGERDUP))) {
+        return MDBX_SUCCESS;
+    } else if ((rc = mdbx_cursor_open(txn, dbi->dbi, &cur))) {
+        return rc;
+    }
+    rc = mdbx_cursor_get(cur, &k, &v, MDBX_FIRST);
+    mdbx_cursor_close(cur);
+    if (rc == MDBX_NOTFOUND) {
+        return MDBX_SUCCESS;
+    } else if (rc) {
+        return rc;
+    }
+    if (k.iov_len == sizeof(uint32_t)) {
+        dbi->keysize = sizeof(uint32_t);
+    }
+    if (v.iov_len == sizeof(uint32_t)) {
+        dbi->datasize = sizeof(uint32_t);
+    }
+    return MDBX_SUCCESS;
+}
+
+// the compression setting is persisted in the main database as the record
+// of the key COMPRESS_PREFIX followed by the name of the database, so that
+// every opener of the database uses the same setting. the value of the record
+// is the threshold as the 8-byte integer.
+#define COMPRESS_PREFIX "lmdbx.compress:"
+
+// get the handle of the main database that is always open
+static inline int main_dbi(MDBX_txn *txn, MDBX_dbi *dbi)
+{
+    return mdbx_dbi_open(txn, NULL, MDBX_DB_ACCEDE, dbi);
+}
+
+static MDBX_val push_compress_key(lua_State *L, const char *name)
+{
+    MDBX_val k = {0};
+
+    lua_pushfstring(L, COMPRESS_PREFIX "%s", name);
+    k.iov_base = (void *)lua_tolstring(L, -1, &k.iov_len);
+    return k;
+}
+
+// load the persisted compression setting of the database into dbi->compress.
+// if it is enabled by the option, it must be the same as the persisted one.
+// *persist is set to 1 if the setting must be persisted.
+static int load_compress(lua_State *L, MDBX_txn *txn, const char *name,
+                         lmdbx_dbi_t *dbi, int *persist)
+{
+    lmdbx_compress_t *c = &dbi->compress;
+    MDBX_val k          = push_compress_key(L, name);
+    MDBX_val v          = {0};
+    MDBX_stat stat      = {0};
+    MDBX_dbi main       = 0;
+    uint64_t threshold  = 0;
+    int rc              = main_dbi(txn, &main);
+
+    if (rc == MDBX_SUCCESS) {
+        rc = mdbx_get(txn, main, &k, &v);
+    }
+    lua_pop(L, 1);
+    *persist = 0;
+    if (rc == MDBX_SUCCESS) {
+        if (v.iov_len != sizeof(threshold)) {
+            return MDBX_CORRUPTED;
+        }
+        memcpy(&threshold, v.iov_base, sizeof(threshold));
+        if (c->enabled && c->threshold != threshold) {
+            return MDBX_INCOMPATIBLE;
+        }
+        c->enabled   = 1;
+        c->threshold = threshold;
+        return MDBX_SUCCESS;
+    } else if (rc != MDBX_NOTFOUND || !c->enabled) {
+        return (rc == MDBX_NOTFOUND) ? MDBX_SUCCESS : rc;
+    }
+
+    // the values stored without the header cannot be read as compressed
+    rc = mdbx_dbi_stat(txn, dbi->dbi, &stat, sizeof(stat));
+    if (rc == MDBX_SUCCESS && stat.ms_entries) {
+        rc = MDBX_INCOMPATIBLE;
+    }
+    *persist = rc == MDBX_SUCCESS;
+    return rc;
+}
+
+static int save_compress(lua_State *L, MDBX_txn *txn, const char *name,
+                         const lmdbx_compress_t *c)
+{
+    uint64_t threshold = c->threshold;
+    MDBX_val k         = push_compress_key(L, name);
+    MDBX_val v         = {.iov_base = &threshold, .iov_len = sizeof(threshold)};
+    MDBX_dbi main      = 0;
+    int rc             = main_dbi(txn, &main);
+
+    if (rc == MDBX_SUCCESS) {
+        rc = mdbx_put(txn, main, &k, &v, MDBX_UPSERT);
+    }
+    lua_pop(L, 1);
+    return rc;
+}
+
+int lmdbx_dbi_delcompress(lua_State *L, MDBX_txn *txn, lmdbx_dbi_t *dbi)
+{
+    MDBX_val k    = {0};
+    MDBX_dbi main = 0;
+    int rc        = 0;
+
+    if (!dbi->compress.enabled || dbi->name_ref == LUA_NOREF) {
+        return MDBX_SUCCESS;
+    } else if ((rc = main_dbi(txn, &main))) {
+        return rc;
+    }
+    lauxh_pushref(L, dbi->name_ref);
+    k  = push_compress_key(L, lua_tostring(L, -1));
+    rc = mdbx_del(txn, main, &k, NULL);
+    lua_pop(L, 2);
+    return (rc == MDBX_NOTFOUND) ? MDBX_SUCCESS : rc;
+}
+
 int lmdbx_dbi_open_lua(lua_State *L)
 {
-    lmdbx_txn_t *txn  = lauxh_checkudata(L, 1, LMDBX_TXN_MT);
-    const char *name  = lauxh_optstring(L, 2, NULL);
-    lua_Integer flags = lmdbx_checkflags(L, 3);
-    lmdbx_env_t *env  = NULL;
-    lmdbx_dbi_t *dbi  = NULL;
-    int rc            = 0;
+    lmdbx_txn_t *txn          = lauxh_checkudata(L, 1, LMDBX_TXN_MT);
+    const char *name          = lauxh_optstring(L, 2, NULL);
+    int top                   = lua_gettop(L);
+    MDBX_cmp_func *keycmp     = NULL;
+    MDBX_cmp_func *datacmp    = NULL;
+    lmdbx_compress_t compress = {0};
+    lua_Integer threshold     = 0;
+    lua_Integer flags         = 0;
+    lmdbx_env_t *env          = NULL;
+    lmdbx_dbi_t *dbi          = NULL;
+    lmdbx_dbi_t *cached       = NULL;
+    int persist               = 0;
+    int rc                    = 0;
+
+    // txn:dbi_open([name [, ...flags [, opts]]])
+    // opts.keycmp and opts.datacmp are the names of built-in comparators.
+    // opts.compress is the minimum size of the values to be compressed, or
+    // 0 to store the values as is. the values are stored with the header in
+    // either case. the setting is persisted when the empty database is
+    // opened with it, and the database is opened with the persisted setting
+    // after that. the main database cannot be compressed.
+    if (top > 2 && lua_type(L, top) == LUA_TTABLE) {
+        keycmp  = optcmpfield(L, top, "keycmp");
+        datacmp = optcmpfield(L, top, "datacmp");
+        lua_getfield(L, top, "compress");
+        compress.enabled = !lua_isnil(L, -1);
+        lua_pop(L, 1);
+        threshold = lmdbx_optintfield(L, top, "compress", 0);
+        if (threshold < 0) {
+            lauxh_argerror(L, top, "field 'compress' must be greater than "
+                                   "or equal to 0");
+        }
+        compress.threshold = threshold;
+        lua_settop(L, --top);
+    }
+    flags = lmdbx_checkflags(L, 3);
 
     // push index table
     lua_settop(L, 2);
@@ -96,8 +278,36 @@ int lmdbx_dbi_open_lua(lua_State *L)
     env = lauxh_checkudata(L, -1, LMDBX_ENV_MT);
     lauxh_pushref(L, env->dbis_ref);
 
-    dbi = lua_newuserdata(L, sizeof(lmdbx_dbi_t));
-    rc  = mdbx_dbi_open(txn->txn, name, flags, &dbi->dbi);
+    dbi           = lua_newuserdata(L, sizeof(lmdbx_dbi_t));
+    dbi->compress = compress;
+    rc = mdbx_dbi_open_ex(txn->txn, name, flags, &dbi->dbi, keycmp, datacmp);
+    if (rc == MDBX_SUCCESS) {
+        unsigned state = 0;
+
+        rc = mdbx_dbi_flags_ex(txn->txn, dbi->dbi, &dbi->flags, &state);
+        // the int64 comparator expects packed integers, so convert them in
+        // the same way as INTEGERKEY and INTEGERDUP
+        if (lmdbx_cmp_isint(keycmp)) {
+            dbi->flags |= MDBX_INTEGERKEY;
+        }
+        if (lmdbx_cmp_isint(datacmp)) {
+            dbi->flags |= MDBX_INTEGERDUP;
+        }
+        if (rc == MDBX_SUCCESS) {
+            rc = get_intsize(txn->txn, dbi);
+        }
+        if (rc == MDBX_SUCCESS && name) {
+            rc = load_compress(L, txn->txn, name, dbi, &persist);
+        } else if (rc == MDBX_SUCCESS && compress.enabled) {
+            // the main database holds the persisted settings
+            rc = MDBX_INCOMPATIBLE;
+        }
+        // the compressed values cannot be sorted as duplicates
+        if (rc == MDBX_SUCCESS && dbi->compress.enabled &&
+            (dbi->flags & MDBX_DUPSORT)) {
+            rc = MDBX_INCOMPATIBLE;
+        }
+    }
     if (rc) {
         if (rc == MDBX_NOTFOUND) {
             return 0;
@@ -111,14 +321,41 @@ int lmdbx_dbi_open_lua(lua_State *L)
     lua_rawgeti(L, 4, dbi->dbi);
     if (lua_isnoneornil(L, -1)) {
         lua_pop(L, 1);
+        if (persist &&
+            (rc = save_compress(L, txn->txn, name, &dbi->compress))) {
+            lua_pushnil(L);
+            lmdbx_pusherror(L, rc);
+            return 2;
+        }
         // create new dbi object
         lauxh_setmetatable(L, LMDBX_DBI_MT);
-        dbi->env_ref = lauxh_refat(L, 3);
+        dbi->env_ref  = lauxh_refat(L, 3);
+        dbi->name_ref = (name) ? lauxh_refat(L, 2) : LUA_NOREF;
         // add dbi to index table
         lua_pushvalue(L, -1);
         lua_rawseti(L, 4, dbi->dbi);
+        return 1;
     }
 
+    // the flags derived from the comparators and the compression setting of
+    // the dbi that is already open cannot be changed, because the handles of
+    // the dbi refer to them.
+    cached = lua_touserdata(L, -1);
+    if ((dbi->flags & ~cached->flags) ||
+        cached->compress.enabled != dbi->compress.enabled ||
+        cached->compress.threshold != dbi->compress.threshold) {
+        lua_pushnil(L);
+        lmdbx_pusherror(L, MDBX_INCOMPATIBLE);
+        return 2;
+    } else if (persist &&
+               (rc = save_compress(L, txn->txn, name, &dbi->compress))) {
+        lua_pushnil(L);
+        lmdbx_pusherror(L, rc);
+        return 2;
+    }
+    // the database may have been empty when the dbi was opened
+    cached->keysize  = dbi->keysize;
+    cached->datasize = dbi->datasize;
     return 1;
 }
 
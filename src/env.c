@@ -151,6 +151,16 @@ static int begin_lua(lua_State *L)
     return lmdbx_txn_begin_lua(L);
 }
 
+static int bulk_loader_lua(lua_State *L)
+{
+    return lmdbx_loader_new_lua(L);
+}
+
+static int id_allocator_lua(lua_State *L)
+{
+    return lmdbx_idalloc_new_lua(L);
+}
+
 static int get_maxvalsize_lua(lua_State *L)
 {
     lmdbx_env_t *env  = lauxh_checkudata(L, 1, LMDBX_ENV_MT);
@@ -704,6 +714,8 @@ void lmdbx_env_init(lua_State *L, int errno_ref)
         {"get_maxkeysize",    get_maxkeysize_lua   },
         {"get_maxvalsize",    get_maxvalsize_lua   },
         {"begin",             begin_lua            },
+        {"bulk_loader",       bulk_loader_lua      },
+        {"id_allocator",      id_allocator_lua     },
         {"reader_list",       reader_list_lua      },
         {"reader_check",      reader_check_lua     },
         {"thread_register",   thread_register_lua  },
@@ -0,0 +1,316 @@
+/**
+ * Copyright (C) 2023 Masatoshi Fukunaga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+#include "lmdbx.h"
+
+// a filter is evaluated against the values in the C loop of the cursor, so
+// that the values that do not match are never pushed onto the stack.
+//
+//  {
+//      minlen = <integer>,   -- length of value >= minlen
+//      maxlen = <integer>,   -- length of value <= maxlen
+//      contains = <string>,  -- value contains the bytes
+//      -- the numbers at the fixed offsets of the value, the types are the
+//      -- integer and floating point types of the schema
+//      {type = 'u32', offset = 0, op = '>=', value = 10},
+//      ...
+//  }
+
+enum {
+    OP_EQ = 0,
+    OP_NE,
+    OP_LT,
+    OP_LE,
+    OP_GT,
+    OP_GE,
+};
+
+typedef struct {
+    lmdbx_field_t field;
+    int op;
+    union {
+        int64_t i64;
+        uint64_t u64;
+        double f64;
+    } value;
+} filter_cmp_t;
+
+struct lmdbx_filter {
+    size_t minlen;
+    size_t maxlen;
+    // the bytes to search are stored after the comparisons
+    const char *needle;
+    size_t nlen;
+    int ncmp;
+    filter_cmp_t cmps[];
+};
+
+static int parse_op(const char *op)
+{
+    static const char *const ops[] = {
+        [OP_EQ] = "==", [OP_NE] = "~=", [OP_LT] = "<",
+        [OP_LE] = "<=", [OP_GT] = ">",  [OP_GE] = ">=",
+    };
+
+    for (int i = 0; i < (int)(sizeof(ops) / sizeof(ops[0])); i++) {
+        if (strcmp(op, ops[i]) == 0) {
+            return i;
+        }
+    }
+    // "!=" is also accepted
+    return (strcmp(op, "!=") == 0) ? OP_NE : -1;
+}
+
+static void check_cmp(lua_State *L, int idx, int arg, int i,
+                      filter_cmp_t *c)
+{
+    lua_Integer offset = 0;
+
+    if (!lua_istable(L, idx)) {
+        lauxh_argerror(L, arg, "filter#%d must be table, got %s", i,
+                       luaL_typename(L, idx));
+    }
+
+    lua_getfield(L, idx, "type");
+    if (lua_type(L, -1) != LUA_TSTRING ||
+        lmdbx_schema_parsetype(lua_tostring(L, -1), &c->field) ||
+        c->field.type == LMDBX_FIELD_BOOL ||
+        c->field.type == LMDBX_FIELD_STRING) {
+        lauxh_argerror(L, arg, "filter#%d type must be integer or floating "
+                               "point type string", i);
+    }
+    lua_pop(L, 1);
+
+    offset = lmdbx_optintfield(L, idx, "offset", 0);
+    if (offset < 0) {
+        lauxh_argerror(L, arg, "filter#%d offset must be greater than or "
+                               "equal to 0", i);
+    }
+    c->field.offset = offset;
+
+    lua_getfield(L, idx, "op");
+    if (lua_type(L, -1) != LUA_TSTRING ||
+        (c->op = parse_op(lua_tostring(L, -1))) < 0) {
+        lauxh_argerror(L, arg, "filter#%d op must be comparison operator", i);
+    }
+    lua_pop(L, 1);
+
+    lua_getfield(L, idx, "value");
+    if (lua_type(L, -1) != LUA_TNUMBER) {
+        lauxh_argerror(L, arg, "filter#%d value must be number, got %s", i,
+                       luaL_typename(L, -1));
+    } else if (c->field.type == LMDBX_FIELD_FLOAT) {
+        c->value.f64 = lua_tonumber(L, -1);
+    } else if (!lmdbx_isinteger(L, -1)) {
+        lauxh_argerror(L, arg, "filter#%d value must be integer", i);
+    } else if (c->field.type == LMDBX_FIELD_INT) {
+        c->value.i64 = lua_tointeger(L, -1);
+    } else if (lua_tointeger(L, -1) < 0) {
+        lauxh_argerror(L, arg, "filter#%d value must be unsigned integer",
+                       i);
+    } else {
+        c->value.u64 = lua_tointeger(L, -1);
+    }
+    lua_pop(L, 1);
+}
+
+lmdbx_filter_t *lmdbx_filter_check(lua_State *L, int idx, int arg)
+{
+    lmdbx_filter_t *f = NULL;
+    size_t minlen     = 0;
+    size_t maxlen     = SIZE_MAX;
+    const char *s     = NULL;
+    size_t nlen       = 0;
+    int ncmp          = 0;
+    lua_Integer n     = 0;
+
+    idx = lmdbx_absindex(L, idx);
+    if (!lua_istable(L, idx)) {
+        lauxh_argerror(L, arg, "field 'filter' must be table, got %s",
+                       luaL_typename(L, idx));
+    }
+    if ((n = lmdbx_optintfield(L, idx, "minlen", 0)) < 0) {
+        lauxh_argerror(L, arg, "filter.minlen must be greater than or "
+                               "equal to 0");
+    }
+    minlen = n;
+    if ((n = lmdbx_optintfield(L, idx, "maxlen", -1)) >= 0) {
+        maxlen = n;
+    }
+    lua_getfield(L, idx, "contains");
+    if (!lua_isnil(L, -1)) {
+        if (lua_type(L, -1) != LUA_TSTRING) {
+            lauxh_argerror(L, arg, "filter.contains must be string, got %s",
+                           luaL_typename(L, -1));
+        }
+        s = lua_tolstring(L, -1, &nlen);
+    }
+    ncmp = (int)lmdbx_rawlen(L, idx);
+
+    f  = lua_newuserdata(L, sizeof(lmdbx_filter_t) +
+                                sizeof(filter_cmp_t) * ncmp + nlen);
+    *f = (lmdbx_filter_t){
+        .minlen = minlen,
+        .maxlen = maxlen,
+        .needle = NULL,
+        .nlen   = nlen,
+        .ncmp   = ncmp,
+    };
+    if (s) {
+        char *needle = (char *)&f->cmps[ncmp];
+        memcpy(needle, s, nlen);
+        f->needle = needle;
+    }
+    for (int i = 0; i < ncmp; i++) {
+        lua_rawgeti(L, idx, i + 1);
+        check_cmp(L, -1, arg, i + 1, &f->cmps[i]);
+        lua_pop(L, 1);
+    }
+    // remove the contains field
+    lua_remove(L, -2);
+
+    return f;
+}
+
+static inline int contains(const char *p, size_t len, const char *needle,
+                           size_t nlen)
+{
+    const char *end = NULL;
+
+    if (nlen == 0) {
+        return 1;
+    } else if (len < nlen) {
+        return 0;
+    }
+    end = p + len - nlen;
+    // find the first byte of the needle and then compare the rest
+    while (p <= end && (p = memchr(p, *needle, end - p + 1))) {
+        if (memcmp(p, needle, nlen) == 0) {
+            return 1;
+        }
+        p++;
+    }
+    return 0;
+}
+
+#define compare(a, b) (((a) > (b)) - ((a) < (b)))
+
+static inline int match_cmp(const filter_cmp_t *c, const MDBX_val *v)
+{
+    const char *p = (const char *)v->iov_base + c->field.offset;
+    int cmp       = 0;
+
+    if (v->iov_len < c->field.offset + c->field.width) {
+        // the value is too short to have the field
+        return 0;
+    }
+
+    if (c->field.type == LMDBX_FIELD_FLOAT) {
+        double f64 = 0;
+        if (c->field.width == sizeof(float)) {
+            float f32 = 0;
+            memcpy(&f32, p, sizeof(f32));
+            f64 = f32;
+        } else {
+            memcpy(&f64, p, sizeof(f64));
+        }
+        // NaN does not match any operator except ~=
+        if (f64 != f64) {
+            return c->op == OP_NE;
+        }
+        cmp = compare(f64, c->value.f64);
+    } else if (c->field.type == LMDBX_FIELD_INT) {
+        int64_t i64 = 0;
+        switch (c->field.width) {
+        case 1: {
+            int8_t i8 = 0;
+            memcpy(&i8, p, 1);
+            i64 = i8;
+        } break;
+        case 2: {
+            int16_t i16 = 0;
+            memcpy(&i16, p, 2);
+            i64 = i16;
+        } break;
+        case 4: {
+            int32_t i32 = 0;
+            memcpy(&i32, p, 4);
+            i64 = i32;
+        } break;
+        default:
+            memcpy(&i64, p, 8);
+        }
+        cmp = compare(i64, c->value.i64);
+    } else {
+        uint64_t u64 = 0;
+        switch (c->field.width) {
+        case 1: {
+            uint8_t u8 = 0;
+            memcpy(&u8, p, 1);
+            u64 = u8;
+        } break;
+        case 2: {
+            uint16_t u16 = 0;
+            memcpy(&u16, p, 2);
+            u64 = u16;
+        } break;
+        case 4: {
+            uint32_t u32 = 0;
+            memcpy(&u32, p, 4);
+            u64 = u32;
+        } break;
+        default:
+            memcpy(&u64, p, 8);
+        }
+        cmp = compare(u64, c->value.u64);
+    }
+
+    switch (c->op) {
+    case OP_EQ:
+        return cmp == 0;
+    case OP_NE:
+        return cmp != 0;
+    case OP_LT:
+        return cmp < 0;
+    case OP_LE:
+        return cmp <= 0;
+    case OP_GT:
+        return cmp > 0;
+    default:
+        return cmp >= 0;
+    }
+}
+
+int lmdbx_filter_match(const lmdbx_filter_t *f, const MDBX_val *v)
+{
+    if (v->iov_len < f->minlen || v->iov_len > f->maxlen ||
+        (f->needle &&
+         !contains(v->iov_base, v->iov_len, f->needle, f->nlen))) {
+        return 0;
+    }
+    for (int i = 0; i < f->ncmp; i++) {
+        if (!match_cmp(&f->cmps[i], v)) {
+            return 0;
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,198 @@
+/**
+ * Copyright (C) 2023 Masatoshi Fukunaga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+#include "lmdbx.h"
+
+#define DEFAULT_BLOCK 1000
+
+// reserve a block of IDs from the sequence of the database in a short write
+// transaction. libmdbx returns MDBX_BUSY if the calling thread already has a
+// write transaction.
+static int fetch(lua_State *L, lmdbx_idalloc_t *ia, uint64_t *next,
+                 uint64_t *last)
+{
+    MDBX_env *env  = lmdbx_env_ref(L, ia->env_ref);
+    MDBX_txn *txn  = NULL;
+    uint64_t start = 0;
+    int rc         = 0;
+
+    if (!env) {
+        return MDBX_EINVAL;
+    } else if ((rc = mdbx_txn_begin(env, NULL, MDBX_TXN_READWRITE, &txn))) {
+        return rc;
+    } else if ((rc = mdbx_dbi_sequence(txn, ia->dbi, &start, ia->block))) {
+        mdbx_txn_abort(txn);
+        return rc;
+    } else if ((rc = mdbx_txn_commit(txn))) {
+        return rc;
+    }
+    *next = start;
+    *last = start + ia->block;
+    ia->refills++;
+    return MDBX_SUCCESS;
+}
+
+static int next_lua(lua_State *L)
+{
+    lmdbx_idalloc_t *ia = lauxh_checkudata(L, 1, LMDBX_IDALLOC_MT);
+    lmdbx_txn_t *txn    = lauxh_optudata(L, 2, LMDBX_TXN_MT, NULL);
+    uint64_t id         = 0;
+    int rc              = 0;
+
+    // ia:next([txn])
+    // txn must be the write transaction of the calling thread if it has one.
+    // when the blocks are exhausted, a single ID is taken from the sequence
+    // in txn so that it is rolled back with txn. a block reserved in txn
+    // would be kept by the allocator even if txn is aborted.
+    if (ia->next == ia->last && ia->pnext < ia->plast) {
+        // switch to the prefetched block
+        ia->next  = ia->pnext;
+        ia->last  = ia->plast;
+        ia->pnext = ia->plast = 0;
+    }
+    if (ia->next < ia->last) {
+        id = ia->next++;
+    } else if (txn) {
+        rc = mdbx_dbi_sequence(txn->txn, ia->dbi, &id, 1);
+    } else if ((rc = fetch(L, ia, &ia->next, &ia->last)) == MDBX_SUCCESS) {
+        id = ia->next++;
+    }
+
+    if (rc) {
+        lua_pushnil(L);
+        lmdbx_pusherror(L, rc);
+        return 2;
+    }
+    lua_pushinteger(L, id);
+    return 1;
+}
+
+static int refill_lua(lua_State *L)
+{
+    lmdbx_idalloc_t *ia = lauxh_checkudata(L, 1, LMDBX_IDALLOC_MT);
+    int rc              = 0;
+
+    // ia:refill()
+    // prefetch the next block unless it is already prefetched, so that the
+    // write transaction can be run outside of the hot path. it must be called
+    // while the calling thread has no write transaction.
+    if (ia->pnext == ia->plast &&
+        (rc = fetch(L, ia, &ia->pnext, &ia->plast))) {
+        lua_pushboolean(L, 0);
+        lmdbx_pusherror(L, rc);
+        return 2;
+    }
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+static int remaining_lua(lua_State *L)
+{
+    lmdbx_idalloc_t *ia = lauxh_checkudata(L, 1, LMDBX_IDALLOC_MT);
+    lua_pushinteger(L, (ia->last - ia->next) + (ia->plast - ia->pnext));
+    return 1;
+}
+
+static int stat_lua(lua_State *L)
+{
+    lmdbx_idalloc_t *ia = lauxh_checkudata(L, 1, LMDBX_IDALLOC_MT);
+
+    lua_createtable(L, 0, 3);
+    lauxh_pushint2tbl(L, "block", ia->block);
+    lauxh_pushint2tbl(L, "remaining",
+                      (ia->last - ia->next) + (ia->plast - ia->pnext));
+    lauxh_pushint2tbl(L, "refills", ia->refills);
+    return 1;
+}
+
+static int gc_lua(lua_State *L)
+{
+    lmdbx_idalloc_t *ia = lauxh_checkudata(L, 1, LMDBX_IDALLOC_MT);
+
+    // unused IDs are discarded, the sequence is never rewound
+    ia->dbi_ref = lauxh_unref(L, ia->dbi_ref);
+    ia->env_ref = lauxh_unref(L, ia->env_ref);
+    return 0;
+}
+
+static int tostring_lua(lua_State *L)
+{
+    lmdbx_idalloc_t *ia = lauxh_checkudata(L, 1, LMDBX_IDALLOC_MT);
+    lua_pushfstring(L, LMDBX_IDALLOC_MT ": %p", ia);
+    return 1;
+}
+
+int lmdbx_idalloc_new_lua(lua_State *L)
+{
+    lmdbx_dbi_t *dbi    = lauxh_checkudata(L, 2, LMDBX_DBI_MT);
+    uint64_t block      = lauxh_optuint64(L, 3, DEFAULT_BLOCK);
+    lmdbx_idalloc_t *ia = NULL;
+
+    lauxh_checkudata(L, 1, LMDBX_ENV_MT);
+
+    // env:id_allocator(dbi [, block])
+    // IDs are handed out from the process-local block, and the write
+    // transaction is required only to reserve the next block.
+    if (block < 1) {
+        lauxh_argerror(L, 3, "block must be greater than 0");
+    }
+
+    ia  = lua_newuserdata(L, sizeof(lmdbx_idalloc_t));
+    *ia = (lmdbx_idalloc_t){
+        .env_ref = LUA_NOREF,
+        .dbi_ref = LUA_NOREF,
+        .dbi     = dbi->dbi,
+        .block   = block,
+    };
+    lauxh_setmetatable(L, LMDBX_IDALLOC_MT);
+    ia->env_ref = lauxh_refat(L, 1);
+    ia->dbi_ref = lauxh_refat(L, 2);
+
+    return 1;
+}
+
+void lmdbx_idalloc_init(lua_State *L, int errno_ref)
+{
+    struct luaL_Reg mmethod[] = {
+        {"__tostring", tostring_lua},
+        {"__gc",       gc_lua      },
+        {NULL,         NULL        }
+    };
+    struct luaL_Reg method[] = {
+        {"next",      next_lua     },
+        {"refill",    refill_lua   },
+        {"remaining", remaining_lua},
+        {"stat",      stat_lua     },
+        {NULL,        NULL         }
+    };
+
+    // create metatable
+    luaL_newmetatable(L, LMDBX_IDALLOC_MT);
+    // metamethods
+    lmdbx_register(L, mmethod, errno_ref);
+    // methods
+    lua_pushstring(L, "__index");
+    lua_newtable(L);
+    lmdbx_register(L, method, errno_ref);
+    lua_rawset(L, -3);
+    lua_pop(L, 1);
+}
@@ -154,6 +154,10 @@ LUALIB_API int luaopen_libmdbx(lua_State *L)
     lmdbx_dbi_init(L, errno_ref);
     lmdbx_dbh_init(L, errno_ref);
     lmdbx_cursor_init(L, errno_ref);
+    lmdbx_view_init(L, errno_ref);
+    lmdbx_loader_init(L, errno_ref);
+    lmdbx_idalloc_init(L, errno_ref);
+    lmdbx_schema_init(L, errno_ref);
 
     lua_newtable(L);
     lauxh_pushref(L, errno_ref);
@@ -162,6 +166,12 @@ LUALIB_API int luaopen_libmdbx(lua_State *L)
     lmdbx_debug_init(L);
     lua_setfield(L, -2, "debug");
 
+    lmdbx_tuple_init(L);
+    lua_setfield(L, -2, "tuple");
+
+    lmdbx_msgpack_init(L);
+    lua_setfield(L, -2, "msgpack");
+
 #define pushfn2tbl(name, func)                                                 \
  do {                                                                          \
   lua_pushstring(L, (name));                                                   \
@@ -180,6 +190,7 @@ LUALIB_API int luaopen_libmdbx(lua_State *L)
     pushfn2tbl("get_sysraminfo", get_sysraminfo_lua);
 
     pushfn2tbl("new", lmdbx_env_create_lua);
+    pushfn2tbl("schema", lmdbx_schema_new_lua);
     errno_ref = lauxh_unref(L, errno_ref);
 
 #undef pushfn2tbl
@@ -26,6 +26,7 @@
 #include "../deps/libmdbx/mdbx.h"
 // #include "mdbx.h"
 #include <lauxhlib.h>
+#include <string.h>
 
 static inline void lmdbx_pusherror(lua_State *L, int errnum)
 {
@@ -60,6 +61,111 @@ static inline lua_Integer lmdbx_checkflags(lua_State *L, int idx)
     return flg;
 }
 
+static inline int lmdbx_optboolfield(lua_State *L, int idx, const char *k,
+                                     int def)
+{
+    int v = def;
+
+    lua_getfield(L, idx, k);
+    if (!lua_isnil(L, -1)) {
+        if (!lua_isboolean(L, -1)) {
+            lauxh_argerror(L, idx, "field '%s' must be boolean, got %s", k,
+                           luaL_typename(L, -1));
+        }
+        v = lua_toboolean(L, -1);
+    }
+    lua_pop(L, 1);
+    return v;
+}
+
+static inline lua_Integer lmdbx_optintfield(lua_State *L, int idx,
+                                            const char *k, lua_Integer def)
+{
+    lua_Integer v = def;
+
+    lua_getfield(L, idx, k);
+    if (!lua_isnil(L, -1)) {
+        if (lua_type(L, -1) != LUA_TNUMBER) {
+            lauxh_argerror(L, idx, "field '%s' must be integer, got %s", k,
+                           luaL_typename(L, -1));
+        }
+        v = lua_tointeger(L, -1);
+    }
+    lua_pop(L, 1);
+    return v;
+}
+
+static inline size_t lmdbx_rawlen(lua_State *L, int idx)
+{
+#if LUA_VERSION_NUM >= 502
+    return lua_rawlen(L, idx);
+#else
+    return lua_objlen(L, idx);
+#endif
+}
+
+// returns 1 if the number at idx has an integer representation.
+static inline int lmdbx_isinteger(lua_State *L, int idx)
+{
+#if LUA_VERSION_NUM >= 503
+    return lua_isinteger(L, idx);
+#else
+    lua_Number n = lua_tonumber(L, idx);
+    return n >= -9223372036854775808.0 && n < 9223372036854775808.0 &&
+           n == (lua_Number)(lua_Integer)n;
+#endif
+}
+
+static inline int lmdbx_absindex(lua_State *L, int idx)
+{
+    return (idx < 0 && idx > LUA_REGISTRYINDEX) ? lua_gettop(L) + idx + 1 :
+                                                  idx;
+}
+
+/**
+ * lmdbx_sortkeys sorts the indexes of keys in the order of the database.
+ * it is a stable bottom-up merge sort, so the equal keys keep their order.
+ * tmp must have the same number of elements as idx.
+ */
+static inline void lmdbx_sortkeys(const MDBX_txn *txn, MDBX_dbi dbi,
+                                  const MDBX_val *keys, size_t *idx,
+                                  size_t *tmp, size_t n)
+{
+    size_t *src = idx;
+    size_t *dst = tmp;
+
+    for (size_t w = 1; w < n; w *= 2) {
+        for (size_t lo = 0; lo < n; lo += w * 2) {
+            size_t mid = (lo + w < n) ? lo + w : n;
+            size_t hi  = (lo + w * 2 < n) ? lo + w * 2 : n;
+            size_t i   = lo;
+            size_t j   = mid;
+            size_t k   = lo;
+
+            while (i < mid && j < hi) {
+                if (mdbx_cmp(txn, dbi, &keys[src[j]], &keys[src[i]]) < 0) {
+                    dst[k++] = src[j++];
+                } else {
+                    dst[k++] = src[i++];
+                }
+            }
+            while (i < mid) {
+                dst[k++] = src[i++];
+            }
+            while (j < hi) {
+                dst[k++] = src[j++];
+            }
+        }
+        // swap buffers
+        src = (src == idx) ? tmp : idx;
+        dst = (dst == idx) ? tmp : idx;
+    }
+
+    if (src != idx) {
+        memcpy(idx, src, sizeof(size_t) * n);
+    }
+}
+
 static inline void lmdbx_pushstat(lua_State *L, MDBX_stat *stat)
 {
     lua_createtable(L, 0, 7);
@@ -215,6 +321,30 @@ void lmdbx_errno_init(lua_State *L);
 
 void lmdbx_debug_init(lua_State *L);
 
+void lmdbx_tuple_init(lua_State *L);
+
+void lmdbx_msgpack_init(lua_State *L);
+// returns the size of the encoded value at idx, or throws an error if the
+// value cannot be encoded.
+size_t lmdbx_msgpack_size(lua_State *L, int idx);
+// encode the value at idx into buf that has the size of lmdbx_msgpack_size.
+void lmdbx_msgpack_encode(lua_State *L, int idx, void *buf);
+// push the decoded value, or returns MDBX_EINVAL if the value is malformed.
+int lmdbx_msgpack_decode(lua_State *L, const MDBX_val *v);
+// compression setting of the database that is fixed when the dbi is opened.
+typedef struct {
+    // values are stored with the compression header
+    int enabled;
+    // values of this size or larger are compressed, 0 to store them as is
+    size_t threshold;
+} lmdbx_compress_t;
+
+// put the encoded value at idx with the cursor, the value is stored with the
+// compression header if compress->enabled is not 0.
+int lmdbx_msgpack_put(lua_State *L, MDBX_cursor *cur, const MDBX_val *k,
+                      int idx, unsigned flags, int dupsort,
+                      const lmdbx_compress_t *compress);
+
 #define LMDBX_ENV_MT "libmdbx.env"
 
 typedef struct {
@@ -226,11 +356,28 @@ typedef struct {
 void lmdbx_env_init(lua_State *L, int errno_ref);
 int lmdbx_env_create_lua(lua_State *L);
 
+// returns the env of the reference, or NULL if the env is closed.
+static inline MDBX_env *lmdbx_env_ref(lua_State *L, int env_ref)
+{
+    lmdbx_env_t *env = NULL;
+
+    lauxh_pushref(L, env_ref);
+    env = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+    return (env) ? env->env : NULL;
+}
+
 #define LMDBX_TXN_MT "libmdbx.txn"
 
 typedef struct {
     int env_ref;
     MDBX_txn *txn;
+    // incremented each time the data returned by the transaction may become
+    // invalid, i.e. on update operations and on commit/abort/reset/renew.
+    uint64_t gen;
+    // incremented each time the transaction is renewed, reset or terminated,
+    // so that the cached cursors bound to it must be reopened.
+    uint64_t epoch;
 } lmdbx_txn_t;
 
 void lmdbx_txn_init(lua_State *L, int errno_ref);
@@ -240,11 +387,28 @@ int lmdbx_txn_begin_lua(lua_State *L);
 
 typedef struct {
     int env_ref;
+    // reference to the name of the database, or LUA_NOREF for the main one
+    int name_ref;
     MDBX_dbi dbi;
+    // database flags obtained when the dbi is opened
+    unsigned flags;
+    // size of the integer keys and values, 4 or 8. it is taken from the first
+    // record every time the dbi is opened, or 8 if the database is empty
+    int keysize;
+    int datasize;
+    // compression setting, it is persisted in the main database and is not
+    // changed after the dbi is opened
+    lmdbx_compress_t compress;
 } lmdbx_dbi_t;
 
 void lmdbx_dbi_init(lua_State *L, int errno_ref);
 int lmdbx_dbi_open_lua(lua_State *L);
+// delete the persisted compression setting of the database that is deleted.
+int lmdbx_dbi_delcompress(lua_State *L, MDBX_txn *txn, lmdbx_dbi_t *dbi);
+
+// returns the built-in comparator of the name, or NULL if not found
+MDBX_cmp_func *lmdbx_cmp_find(const char *name);
+int lmdbx_cmp_isint(MDBX_cmp_func *cmp);
 
 #define LMDBX_DBH_MT "libmdbx.dbh"
 
@@ -253,6 +417,13 @@ typedef struct {
     int txn_ref;
     lmdbx_dbi_t *dbi;
     lmdbx_txn_t *txn;
+    int viewmode;
+    // cursor cached for the single descent operations
+    MDBX_cursor *cur;
+    uint64_t cur_epoch;
+    // buffer to preserve the old value of replace, reused across calls
+    char *buf;
+    size_t bufsize;
 } lmdbx_dbh_t;
 
 void lmdbx_dbh_init(lua_State *L, int errno_ref);
@@ -262,10 +433,277 @@ int lmdbx_dbh_open_lua(lua_State *L);
 
 typedef struct {
     int txn_ref;
+    lmdbx_txn_t *txn;
     MDBX_cursor *cur;
+    int viewmode;
+    // database flags of the dbi of the cursor
+    unsigned flags;
+    // size of the integer keys and values of the dbi of the cursor
+    int keysize;
+    int datasize;
+    // compression setting of the dbi of the cursor
+    lmdbx_compress_t compress;
+    // scratch buffer for get_batch, reused across calls
+    MDBX_val *batch;
+    size_t nbatch;
 } lmdbx_cursor_t;
 
 void lmdbx_cursor_init(lua_State *L, int errno_ref);
 int lmdbx_cursor_open_lua(lua_State *L);
+int lmdbx_cursor_range_lua(lua_State *L);
+int lmdbx_cursor_range_prefix_lua(lua_State *L);
+int lmdbx_cursor_aggregate_lua(lua_State *L);
+
+#define LMDBX_LOADER_MT "libmdbx.loader"
+
+typedef struct {
+    int env_ref;
+    int dbi_ref;
+    int progress_ref;
+    MDBX_dbi dbi;
+    int append;
+    unsigned flags;
+    lmdbx_compress_t compress;
+    // pending write transaction and its cursor
+    MDBX_txn *txn;
+    MDBX_cursor *cur;
+    // commit when the dirty space exceeds this size in bytes
+    uint64_t threshold;
+    uint64_t count;
+    uint64_t bytes;
+    uint64_t committed_count;
+    uint64_t committed_bytes;
+    uint64_t commits;
+    double started;
+    // read buffer for the file descriptor source
+    char *buf;
+    size_t cap;
+    size_t len;
+    size_t pos;
+} lmdbx_loader_t;
+
+void lmdbx_loader_init(lua_State *L, int errno_ref);
+int lmdbx_loader_new_lua(lua_State *L);
+
+#define LMDBX_IDALLOC_MT "libmdbx.id_allocator"
+
+typedef struct {
+    int env_ref;
+    int dbi_ref;
+    MDBX_dbi dbi;
+    // number of IDs reserved from the sequence at once
+    uint64_t block;
+    // IDs in [next, last) of the current block are handed out first, and
+    // then the prefetched block [pnext, plast) is used
+    uint64_t next;
+    uint64_t last;
+    uint64_t pnext;
+    uint64_t plast;
+    uint64_t refills;
+} lmdbx_idalloc_t;
+
+void lmdbx_idalloc_init(lua_State *L, int errno_ref);
+int lmdbx_idalloc_new_lua(lua_State *L);
+
+#define LMDBX_VIEW_MT "libmdbx.view"
+
+typedef struct {
+    int txn_ref;
+    lmdbx_txn_t *txn;
+    uint64_t gen;
+    const char *ptr;
+    size_t len;
+    // the view of the space reserved by MDBX_RESERVE can be written
+    int writable;
+} lmdbx_view_t;
+
+#define LMDBX_SCHEMA_MT "libmdbx.schema"
+
+enum {
+    LMDBX_FIELD_INT = 0,
+    LMDBX_FIELD_UINT,
+    LMDBX_FIELD_FLOAT,
+    LMDBX_FIELD_BOOL,
+    LMDBX_FIELD_STRING,
+};
+
+typedef struct {
+    int type;
+    size_t offset;
+    size_t width;
+} lmdbx_field_t;
+
+typedef struct {
+    // maps the field names to the indexes and the indexes to the names
+    int names_ref;
+    size_t size;
+    int nfield;
+    lmdbx_field_t fields[];
+} lmdbx_schema_t;
+
+void lmdbx_schema_init(lua_State *L, int errno_ref);
+int lmdbx_schema_new_lua(lua_State *L);
+// returns the field specified by the name or the index at idx, or throws an
+// error if the field does not exist.
+lmdbx_field_t *lmdbx_schema_checkfield(lua_State *L, lmdbx_schema_t *s,
+                                       int idx);
+// push the field value of the record, or returns MDBX_EINVAL if the record
+// is too short. the value of the unsigned 64-bit field that is greater than
+// INT64_MAX is pushed as the negative integer of the same bits.
+int lmdbx_schema_pushfield(lua_State *L, const lmdbx_field_t *f,
+                           const MDBX_val *v);
+
+// returns 0 if the type string of the field is valid.
+int lmdbx_schema_parsetype(const char *type, lmdbx_field_t *f);
+
+typedef struct lmdbx_filter lmdbx_filter_t;
+
+// compile the filter table at idx and push it onto the stack, or throws an
+// error of the argument arg if the filter is invalid.
+lmdbx_filter_t *lmdbx_filter_check(lua_State *L, int idx, int arg);
+// returns 1 if the value matches all conditions of the filter.
+int lmdbx_filter_match(const lmdbx_filter_t *f, const MDBX_val *v);
+
+void lmdbx_view_init(lua_State *L, int errno_ref);
+void lmdbx_view_new(lua_State *L, int txn_ref, lmdbx_txn_t *txn,
+                    const MDBX_val *v);
+
+// keys of MDBX_INTEGERKEY and values of MDBX_INTEGERDUP are converted from/to
+// lua_Integer in native byte order. the macros take the dbi or the cursor and
+// return the size of the packed integer, or 0 if they are not integers.
+#define LMDBX_INTKEY(x) (((x)->flags & MDBX_INTEGERKEY) ? (x)->keysize : 0)
+#define LMDBX_INTDUP(x) (((x)->flags & MDBX_INTEGERDUP) ? (x)->datasize : 0)
+
+// storage for an integer key or value
+typedef union {
+    uint32_t u32;
+    uint64_t u64;
+} lmdbx_intval_t;
+
+// pack the integer at idx into buf as an isint-byte integer. throws an error
+// if the integer does not fit in 4 bytes.
+static inline void lmdbx_packint(lua_State *L, int idx, int isint,
+                                 lmdbx_intval_t *buf, MDBX_val *v)
+{
+    lua_Integer ival = lauxh_checkinteger(L, idx);
+
+    if (isint == sizeof(uint32_t)) {
+        if (ival < 0 || (uint64_t)ival > UINT32_MAX) {
+            lauxh_argerror(L, idx,
+                           "integer must be between 0 and %u for the 4-byte "
+                           "integer database",
+                           (unsigned)UINT32_MAX);
+        }
+        buf->u32    = (uint32_t)ival;
+        v->iov_base = &buf->u32;
+        v->iov_len  = sizeof(buf->u32);
+        return;
+    }
+    buf->u64    = (uint64_t)ival;
+    v->iov_base = &buf->u64;
+    v->iov_len  = sizeof(buf->u64);
+}
+
+// check a key or value at idx. if isint is not 0, a number is packed into buf
+// as an isint-byte integer, otherwise it must be a string.
+static inline void lmdbx_checkval(lua_State *L, int idx, int isint,
+                                  lmdbx_intval_t *buf, MDBX_val *v)
+{
+    if (isint && lua_type(L, idx) == LUA_TNUMBER) {
+        lmdbx_packint(L, idx, isint, buf, v);
+        return;
+    }
+    v->iov_base = (void *)lauxh_checklstring(L, idx, &v->iov_len);
+}
+
+// push the smallest string that is greater than all strings starting with
+// the prefix, or nil if there is no such string.
+static inline void lmdbx_pushstrinc(lua_State *L, const char *s, size_t len)
+{
+    luaL_Buffer b;
+
+    // trailing 0xFF bytes cannot be incremented
+    while (len > 0 && (unsigned char)s[len - 1] == 0xFF) {
+        len--;
+    }
+    if (len == 0) {
+        lua_pushnil(L);
+        return;
+    }
+    luaL_buffinit(L, &b);
+    luaL_addlstring(&b, s, len - 1);
+    luaL_addchar(&b, (char)((unsigned char)s[len - 1] + 1));
+    luaL_pushresult(&b);
+}
+
+// returns 1 if the value at idx is a string, or a number if isint is not 0.
+static inline int lmdbx_isval(lua_State *L, int idx, int isint)
+{
+    int t = lua_type(L, idx);
+    return t == LUA_TSTRING || (isint && t == LUA_TNUMBER);
+}
+
+// same as lmdbx_checkval but returns 0 if the value is none or nil.
+static inline int lmdbx_optval(lua_State *L, int idx, int isint,
+                               lmdbx_intval_t *buf, MDBX_val *v)
+{
+    if (lua_isnoneornil(L, idx)) {
+        *v = (MDBX_val){.iov_base = NULL, .iov_len = 0};
+        return 0;
+    }
+    lmdbx_checkval(L, idx, isint, buf, v);
+    return 1;
+}
+
+// replace a number at idx with the packed string if isint is not 0.
+static inline void lmdbx_topacked(lua_State *L, int idx, int isint)
+{
+    if (isint && lua_type(L, idx) == LUA_TNUMBER) {
+        lmdbx_intval_t buf = {.u64 = 0};
+        MDBX_val v         = {0};
+
+        lmdbx_packint(L, idx, isint, &buf, &v);
+        lua_pushlstring(L, v.iov_base, v.iov_len);
+        lua_replace(L, (idx < 0) ? idx - 1 : idx);
+    }
+}
+
+// push a value as a string, or as a view that refers to the value in the
+// memory map without copying it. if isint is not 0, a 4 or 8 byte value is
+// pushed as an integer.
+static inline void lmdbx_pushval(lua_State *L, int viewmode, int txn_ref,
+                                 lmdbx_txn_t *txn, int isint,
+                                 const MDBX_val *v)
+{
+    if (isint && v->iov_len == sizeof(uint32_t)) {
+        uint32_t u32 = 0;
+        memcpy(&u32, v->iov_base, sizeof(u32));
+        lua_pushinteger(L, (lua_Integer)u32);
+    } else if (isint && v->iov_len == sizeof(uint64_t)) {
+        uint64_t u64 = 0;
+        memcpy(&u64, v->iov_base, sizeof(u64));
+        lua_pushinteger(L, (lua_Integer)u64);
+    } else if (viewmode) {
+        lmdbx_view_new(L, txn_ref, txn, v);
+    } else {
+        lua_pushlstring(L, v->iov_base, v->iov_len);
+    }
+}
+
+// header byte of the value that is stored without compression
+#define LMDBX_COMPRESS_RAW 0x00
+
+// replace v with the value that has the compression header. the value is
+// compressed if threshold is not 0 and the value is not smaller than it. the
+// buffer of the value is pushed onto the stack.
+void lmdbx_compress_encode(lua_State *L, size_t threshold, MDBX_val *v);
+// replace v with the original value. the buffer of the decompressed value,
+// or nil if not compressed, is pushed onto the stack.
+// returns MDBX_CORRUPTED if the value is malformed.
+int lmdbx_compress_decode(lua_State *L, MDBX_val *v);
+// same as lmdbx_pushval for the value that has the compression header.
+// returns MDBX_CORRUPTED without pushing a value if the value is malformed.
+int lmdbx_compress_pushval(lua_State *L, int viewmode, int txn_ref,
+                           lmdbx_txn_t *txn, const MDBX_val *v);
 
 #endif
@@ -0,0 +1,454 @@
+/**
+ * Copyright (C) 2023 Masatoshi Fukunaga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+#include "lmdbx.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_THRESHOLD (64 * 1024 * 1024)
+// number of items between checks of the dirty space
+#define CHECK_INTERVAL    256
+#define READBUF_SIZE      (64 * 1024)
+
+static double getnow(void)
+{
+    struct timespec ts = {0};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+static void pushstat(lua_State *L, lmdbx_loader_t *ld)
+{
+    double elapsed = getnow() - ld->started;
+
+    lua_createtable(L, 0, 6);
+    lauxh_pushint2tbl(L, "count", ld->count);
+    lauxh_pushint2tbl(L, "bytes", ld->bytes);
+    lauxh_pushint2tbl(L, "commits", ld->commits);
+    lua_pushnumber(L, elapsed);
+    lua_setfield(L, -2, "elapsed");
+    lua_pushnumber(L, (elapsed > 0) ? (double)ld->count / elapsed : 0);
+    lua_setfield(L, -2, "items_per_sec");
+    lua_pushnumber(L, (elapsed > 0) ? (double)ld->bytes / elapsed : 0);
+    lua_setfield(L, -2, "bytes_per_sec");
+}
+
+static void rollback(lmdbx_loader_t *ld)
+{
+    if (ld->cur) {
+        mdbx_cursor_close(ld->cur);
+        ld->cur = NULL;
+    }
+    if (ld->txn) {
+        mdbx_txn_abort(ld->txn);
+        ld->txn = NULL;
+    }
+    // discard the counters of uncommitted items
+    ld->count = ld->committed_count;
+    ld->bytes = ld->committed_bytes;
+}
+
+// call the function in protected mode, and abort the pending transaction
+// before the error is rethrown. otherwise the transaction is left open and
+// blocks the other writers until the loader is collected.
+static void call(lua_State *L, lmdbx_loader_t *ld, int nargs, int nresults)
+{
+    if (lua_pcall(L, nargs, nresults, 0)) {
+        rollback(ld);
+        lua_error(L);
+    }
+}
+
+static void progress(lua_State *L, lmdbx_loader_t *ld)
+{
+    if (ld->progress_ref != LUA_NOREF) {
+        lauxh_pushref(L, ld->progress_ref);
+        pushstat(L, ld);
+        call(L, ld, 1, 0);
+    }
+}
+
+static int commit(lmdbx_loader_t *ld)
+{
+    int rc = 0;
+
+    if (ld->txn) {
+        mdbx_cursor_close(ld->cur);
+        ld->cur = NULL;
+        rc      = mdbx_txn_commit(ld->txn);
+        ld->txn = NULL;
+        if (rc) {
+            ld->count = ld->committed_count;
+            ld->bytes = ld->committed_bytes;
+            return rc;
+        }
+        ld->committed_count = ld->count;
+        ld->committed_bytes = ld->bytes;
+        ld->commits++;
+    }
+    return 0;
+}
+
+static int put(lua_State *L, lmdbx_loader_t *ld, MDBX_val *k, MDBX_val *v)
+{
+    int rc = 0;
+
+    if (!ld->txn) {
+        MDBX_env *env  = lmdbx_env_ref(L, ld->env_ref);
+        unsigned flags = 0;
+        unsigned state = 0;
+
+        if (!env) {
+            // the env is closed
+            return MDBX_EINVAL;
+        } else if ((rc = mdbx_txn_begin(env, NULL, MDBX_TXN_READWRITE,
+                                        &ld->txn))) {
+            ld->txn = NULL;
+            return rc;
+        } else if ((rc = mdbx_dbi_flags_ex(ld->txn, ld->dbi, &flags,
+                                           &state)) ||
+                   (rc = mdbx_cursor_open(ld->txn, ld->dbi, &ld->cur))) {
+            ld->cur = NULL;
+            rollback(ld);
+            return rc;
+        }
+
+        // pairs must be sorted in the append mode
+        ld->flags = 0;
+        if (ld->append) {
+            ld->flags = (flags & MDBX_DUPSORT) ?
+                            MDBX_APPEND | MDBX_APPENDDUP :
+                            MDBX_APPEND;
+        }
+    }
+
+    if (ld->compress.enabled) {
+        lmdbx_compress_encode(L, ld->compress.threshold, v);
+        rc = mdbx_cursor_put(ld->cur, k, v, ld->flags);
+        lua_pop(L, 1);
+    } else {
+        rc = mdbx_cursor_put(ld->cur, k, v, ld->flags);
+    }
+    if (rc) {
+        rollback(ld);
+        return rc;
+    }
+    ld->count++;
+    ld->bytes += k->iov_len + v->iov_len;
+
+    // commit if the dirty space of the transaction exceeds the threshold
+    if ((ld->count - ld->committed_count) % CHECK_INTERVAL == 0) {
+        MDBX_txn_info info = {0};
+
+        if ((rc = mdbx_txn_info(ld->txn, &info, 0))) {
+            rollback(ld);
+            return rc;
+        } else if (info.txn_space_dirty >= ld->threshold) {
+            if ((rc = commit(ld))) {
+                return rc;
+            }
+            progress(L, ld);
+        }
+    }
+    return 0;
+}
+
+static inline uint32_t le32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+           (uint32_t)p[3] << 24;
+}
+
+// fill the read buffer until it has at least n bytes.
+// returns 0 on success, 1 on end of file, or -1 on error.
+static int fill(lmdbx_loader_t *ld, int fd, size_t n)
+{
+    if (ld->len - ld->pos >= n) {
+        return 0;
+    } else if (ld->pos) {
+        memmove(ld->buf, ld->buf + ld->pos, ld->len - ld->pos);
+        ld->len -= ld->pos;
+        ld->pos  = 0;
+    }
+
+    if (n > ld->cap) {
+        size_t cap = (n > READBUF_SIZE) ? n : READBUF_SIZE;
+        char *buf  = realloc(ld->buf, cap);
+
+        if (!buf) {
+            errno = ENOMEM;
+            return -1;
+        }
+        ld->buf = buf;
+        ld->cap = cap;
+    }
+
+    while (ld->len < n) {
+        ssize_t rv = read(fd, ld->buf + ld->len, ld->cap - ld->len);
+
+        if (rv > 0) {
+            ld->len += rv;
+        } else if (rv == 0) {
+            return 1;
+        } else if (errno != EINTR) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int load_fd(lua_State *L, lmdbx_loader_t *ld, int fd)
+{
+    MDBX_env *env = lmdbx_env_ref(L, ld->env_ref);
+    int maxkey    = (env) ? mdbx_env_get_maxkeysize_ex(env, 0) : -1;
+
+    if (maxkey < 0) {
+        return MDBX_EINVAL;
+    }
+
+    ld->pos = ld->len = 0;
+    while (1) {
+        const unsigned char *p = NULL;
+        MDBX_val k             = {0};
+        MDBX_val v             = {0};
+        int rc                 = fill(ld, fd, 4);
+
+        if (rc == 1 && ld->len == ld->pos) {
+            // end of records
+            return 0;
+        } else if (rc == 0) {
+            // the lengths are checked before the buffer is grown for them
+            k.iov_len = le32((unsigned char *)ld->buf + ld->pos);
+            rc        = (k.iov_len > (size_t)maxkey) ?
+                            1 :
+                            fill(ld, fd, 4 + k.iov_len + 4);
+        }
+        if (rc == 0) {
+            p         = (unsigned char *)ld->buf + ld->pos;
+            v.iov_len = le32(p + 4 + k.iov_len);
+            rc        = (v.iov_len > MDBX_MAXDATASIZE) ?
+                            1 :
+                            fill(ld, fd, 4 + k.iov_len + 4 + v.iov_len);
+        }
+        if (rc) {
+            rollback(ld);
+            if (rc == 1) {
+                // truncated record or invalid length
+                return MDBX_EINVAL;
+            }
+            return (errno == ENOMEM) ? MDBX_ENOMEM : MDBX_EIO;
+        }
+
+        p          = (unsigned char *)ld->buf + ld->pos;
+        k.iov_base = (void *)(p + 4);
+        v.iov_base = (void *)(p + 4 + k.iov_len + 4);
+        ld->pos += 4 + k.iov_len + 4 + v.iov_len;
+        if ((rc = put(L, ld, &k, &v))) {
+            return rc;
+        }
+    }
+}
+
+static int load_iter(lua_State *L, lmdbx_loader_t *ld, int idx)
+{
+    while (1) {
+        MDBX_val k = {0};
+        MDBX_val v = {0};
+        int rc     = 0;
+
+        lua_pushvalue(L, idx);
+        call(L, ld, 0, 2);
+        if (lua_isnil(L, -2)) {
+            lua_pop(L, 2);
+            return 0;
+        }
+        if (lua_type(L, -2) != LUA_TSTRING || lua_type(L, -1) != LUA_TSTRING) {
+            rollback(ld);
+            return luaL_error(L, "iterator must return key and value as "
+                                 "string, got %s and %s",
+                              luaL_typename(L, -2), luaL_typename(L, -1));
+        }
+        k.iov_base = (void *)lua_tolstring(L, -2, &k.iov_len);
+        v.iov_base = (void *)lua_tolstring(L, -1, &v.iov_len);
+        rc         = put(L, ld, &k, &v);
+        lua_pop(L, 2);
+        if (rc) {
+            return rc;
+        }
+    }
+}
+
+static int load_lua(lua_State *L)
+{
+    lmdbx_loader_t *ld = lauxh_checkudata(L, 1, LMDBX_LOADER_MT);
+    uint64_t count     = ld->count;
+    int rc             = 0;
+
+    // loader:load(src)
+    // src is an iterator function that returns key and value until the key
+    // is nil, or a file descriptor to read the length-prefixed records
+    lua_settop(L, 2);
+    if (lua_isfunction(L, 2)) {
+        rc = load_iter(L, ld, 2);
+    } else {
+        rc = load_fd(L, ld, (int)lauxh_checkinteger(L, 2));
+    }
+
+    if (rc) {
+        lua_pushnil(L);
+        lmdbx_pusherror(L, rc);
+        return 2;
+    }
+    lua_pushinteger(L, ld->count - count);
+    return 1;
+}
+
+static int finish_lua(lua_State *L)
+{
+    lmdbx_loader_t *ld = lauxh_checkudata(L, 1, LMDBX_LOADER_MT);
+    int rc             = commit(ld);
+
+    if (rc) {
+        lua_pushnil(L);
+        lmdbx_pusherror(L, rc);
+        return 2;
+    }
+    progress(L, ld);
+    pushstat(L, ld);
+    return 1;
+}
+
+static int abort_lua(lua_State *L)
+{
+    lmdbx_loader_t *ld = lauxh_checkudata(L, 1, LMDBX_LOADER_MT);
+    rollback(ld);
+    return 0;
+}
+
+static int stat_lua(lua_State *L)
+{
+    lmdbx_loader_t *ld = lauxh_checkudata(L, 1, LMDBX_LOADER_MT);
+    pushstat(L, ld);
+    return 1;
+}
+
+static int gc_lua(lua_State *L)
+{
+    lmdbx_loader_t *ld = lauxh_checkudata(L, 1, LMDBX_LOADER_MT);
+
+    rollback(ld);
+    if (ld->buf) {
+        free(ld->buf);
+        ld->buf = NULL;
+    }
+    ld->progress_ref = lauxh_unref(L, ld->progress_ref);
+    ld->dbi_ref      = lauxh_unref(L, ld->dbi_ref);
+    ld->env_ref      = lauxh_unref(L, ld->env_ref);
+    return 0;
+}
+
+static int tostring_lua(lua_State *L)
+{
+    lmdbx_loader_t *ld = lauxh_checkudata(L, 1, LMDBX_LOADER_MT);
+    lua_pushfstring(L, LMDBX_LOADER_MT ": %p", ld);
+    return 1;
+}
+
+int lmdbx_loader_new_lua(lua_State *L)
+{
+    lmdbx_dbi_t *dbi   = lauxh_checkudata(L, 2, LMDBX_DBI_MT);
+    lua_Integer thresh = DEFAULT_THRESHOLD;
+    int append         = 1;
+    lmdbx_loader_t *ld = NULL;
+
+    // env:bulk_loader(dbi [, opts])
+    lauxh_checkudata(L, 1, LMDBX_ENV_MT);
+    lua_settop(L, 3);
+    if (!lua_isnil(L, 3)) {
+        luaL_checktype(L, 3, LUA_TTABLE);
+        thresh = lmdbx_optintfield(L, 3, "threshold", DEFAULT_THRESHOLD);
+        append = lmdbx_optboolfield(L, 3, "append", 1);
+        lua_getfield(L, 3, "progress");
+        if (!lua_isnil(L, -1) && !lua_isfunction(L, -1)) {
+            lauxh_argerror(L, 3, "field 'progress' must be function, got %s",
+                           luaL_typename(L, -1));
+        }
+        lua_pop(L, 1);
+        if (thresh < 1) {
+            lauxh_argerror(L, 3, "field 'threshold' must be greater than 0");
+        }
+    }
+
+    ld  = lua_newuserdata(L, sizeof(lmdbx_loader_t));
+    *ld = (lmdbx_loader_t){
+        .env_ref      = LUA_NOREF,
+        .dbi_ref      = LUA_NOREF,
+        .progress_ref = LUA_NOREF,
+        .dbi          = dbi->dbi,
+        .append       = append,
+        .compress     = dbi->compress,
+        .threshold    = thresh,
+        .started      = getnow(),
+    };
+    lauxh_setmetatable(L, LMDBX_LOADER_MT);
+    ld->env_ref = lauxh_refat(L, 1);
+    ld->dbi_ref = lauxh_refat(L, 2);
+    if (lua_istable(L, 3)) {
+        lua_getfield(L, 3, "progress");
+        if (lua_isfunction(L, -1)) {
+            ld->progress_ref = lauxh_ref(L);
+        } else {
+            lua_pop(L, 1);
+        }
+    }
+
+    return 1;
+}
+
+void lmdbx_loader_init(lua_State *L, int errno_ref)
+{
+    struct luaL_Reg mmethod[] = {
+        {"__tostring", tostring_lua},
+        {"__gc",       gc_lua      },
+        {NULL,         NULL        }
+    };
+    struct luaL_Reg method[] = {
+        {"load",   load_lua  },
+        {"finish", finish_lua},
+        {"abort",  abort_lua },
+        {"stat",   stat_lua  },
+        {NULL,     NULL      }
+    };
+
+    // create metatable
+    luaL_newmetatable(L, LMDBX_LOADER_MT);
+    // metamethods
+    lmdbx_register(L, mmethod, errno_ref);
+    // methods
+    lua_pushstring(L, "__index");
+    lua_newtable(L);
+    lmdbx_register(L, method, errno_ref);
+    lua_rawset(L, -3);
+    lua_pop(L, 1);
+}
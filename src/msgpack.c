@@ -0,0 +1,475 @@
+/**
+ * Copyright (C) 2023 Masatoshi Fukunaga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+#include "lmdbx.h"
+
+// MessagePack codec for storing Lua values.
+// a table is encoded as an array if its keys are the sequence 1..n,
+// otherwise it is encoded as a map.
+
+#define MSGPACK_MAX_DEPTH 64
+
+typedef struct {
+    // NULL to measure the encoded size only
+    unsigned char *buf;
+    size_t len;
+} msgpack_buf_t;
+
+static inline void put_byte(msgpack_buf_t *b, unsigned char c)
+{
+    if (b->buf) {
+        b->buf[b->len] = c;
+    }
+    b->len++;
+}
+
+static inline void put_bytes(msgpack_buf_t *b, const void *p, size_t n)
+{
+    if (b->buf) {
+        memcpy(b->buf + b->len, p, n);
+    }
+    b->len += n;
+}
+
+// put the code followed by the n bytes big-endian value
+static inline void put_code_be(msgpack_buf_t *b, unsigned char code,
+                               uint64_t u64, int n)
+{
+    put_byte(b, code);
+    for (int i = n - 1; i >= 0; i--) {
+        put_byte(b, (unsigned char)(u64 >> (i * 8)));
+    }
+}
+
+static void put_integer(msgpack_buf_t *b, lua_Integer ival)
+{
+    if (ival >= 0) {
+        if (ival < 0x80) {
+            put_byte(b, (unsigned char)ival);
+        } else if (ival <= UINT8_MAX) {
+            put_code_be(b, 0xcc, ival, 1);
+        } else if (ival <= UINT16_MAX) {
+            put_code_be(b, 0xcd, ival, 2);
+        } else if (ival <= UINT32_MAX) {
+            put_code_be(b, 0xce, ival, 4);
+        } else {
+            put_code_be(b, 0xcf, ival, 8);
+        }
+    } else if (ival >= -32) {
+        put_byte(b, (unsigned char)(0xe0 | (ival + 32)));
+    } else if (ival >= INT8_MIN) {
+        put_code_be(b, 0xd0, (uint64_t)ival, 1);
+    } else if (ival >= INT16_MIN) {
+        put_code_be(b, 0xd1, (uint64_t)ival, 2);
+    } else if (ival >= INT32_MIN) {
+        put_code_be(b, 0xd2, (uint64_t)ival, 4);
+    } else {
+        put_code_be(b, 0xd3, (uint64_t)ival, 8);
+    }
+}
+
+static inline void put_header(msgpack_buf_t *b, size_t n, unsigned char fix,
+                              size_t fixmax, unsigned char code16,
+                              unsigned char code32)
+{
+    if (n <= fixmax) {
+        put_byte(b, fix | (unsigned char)n);
+    } else if (n <= UINT16_MAX) {
+        put_code_be(b, code16, n, 2);
+    } else {
+        put_code_be(b, code32, n, 4);
+    }
+}
+
+static void encode(lua_State *L, int idx, msgpack_buf_t *b, int depth)
+{
+    idx = lmdbx_absindex(L, idx);
+    switch (lua_type(L, idx)) {
+    case LUA_TNIL:
+        put_byte(b, 0xc0);
+        return;
+
+    case LUA_TBOOLEAN:
+        put_byte(b, (lua_toboolean(L, idx)) ? 0xc3 : 0xc2);
+        return;
+
+    case LUA_TNUMBER:
+        if (lmdbx_isinteger(L, idx)) {
+            put_integer(b, lua_tointeger(L, idx));
+        } else {
+            lua_Number num = lua_tonumber(L, idx);
+            uint64_t u64   = 0;
+
+            memcpy(&u64, &num, sizeof(u64));
+            put_code_be(b, 0xcb, u64, 8);
+        }
+        return;
+
+    case LUA_TSTRING: {
+        size_t len    = 0;
+        const char *s = lua_tolstring(L, idx, &len);
+
+        if (len <= 31) {
+            put_byte(b, 0xa0 | (unsigned char)len);
+        } else if (len <= UINT8_MAX) {
+            put_code_be(b, 0xd9, len, 1);
+        } else if (len <= UINT16_MAX) {
+            put_code_be(b, 0xda, len, 2);
+        } else {
+            put_code_be(b, 0xdb, len, 4);
+        }
+        put_bytes(b, s, len);
+        return;
+    }
+
+    case LUA_TTABLE: {
+        size_t len  = lmdbx_rawlen(L, idx);
+        size_t n    = 0;
+        int isarray = 1;
+
+        if (depth >= MSGPACK_MAX_DEPTH) {
+            luaL_error(L, "table nesting too deep to encode");
+        }
+        luaL_checkstack(L, 3, "table nesting too deep to encode");
+        // count the number of entries, and check that all keys are in 1..len
+        lua_pushnil(L);
+        while (lua_next(L, idx)) {
+            lua_pop(L, 1);
+            if (isarray && (lua_type(L, -1) != LUA_TNUMBER ||
+                            !lmdbx_isinteger(L, -1) ||
+                            lua_tointeger(L, -1) < 1 ||
+                            (size_t)lua_tointeger(L, -1) > len)) {
+                isarray = 0;
+            }
+            n++;
+        }
+
+        if (isarray && n == len) {
+            // the keys are the sequence 1..n
+            put_header(b, n, 0x90, 15, 0xdc, 0xdd);
+            for (size_t i = 1; i <= n; i++) {
+                lua_rawgeti(L, idx, i);
+                encode(L, -1, b, depth + 1);
+                lua_pop(L, 1);
+            }
+            return;
+        }
+        put_header(b, n, 0x80, 15, 0xde, 0xdf);
+        lua_pushnil(L);
+        while (lua_next(L, idx)) {
+            encode(L, -2, b, depth + 1);
+            encode(L, -1, b, depth + 1);
+            lua_pop(L, 1);
+        }
+        return;
+    }
+
+    default:
+        luaL_error(L, "unsupported value type: %s", luaL_typename(L, idx));
+    }
+}
+
+size_t lmdbx_msgpack_size(lua_State *L, int idx)
+{
+    msgpack_buf_t b = {.buf = NULL, .len = 0};
+
+    encode(L, idx, &b, 0);
+    return b.len;
+}
+
+void lmdbx_msgpack_encode(lua_State *L, int idx, void *buf)
+{
+    msgpack_buf_t b = {.buf = buf, .len = 0};
+
+    encode(L, idx, &b, 0);
+}
+
+int lmdbx_msgpack_put(lua_State *L, MDBX_cursor *cur, const MDBX_val *k,
+                      int idx, unsigned flags, int dupsort,
+                      const lmdbx_compress_t *compress)
+{
+    MDBX_val v = {.iov_base = NULL, .iov_len = lmdbx_msgpack_size(L, idx)};
+    int rc     = 0;
+
+    if (dupsort || compress->enabled) {
+        // MDBX_RESERVE cannot be used for the sorted duplicates, and the
+        // compressed value must be encoded before it is stored
+        v.iov_base = lua_newuserdata(L, v.iov_len);
+        lmdbx_msgpack_encode(L, idx, v.iov_base);
+        if (compress->enabled) {
+            lmdbx_compress_encode(L, compress->threshold, &v);
+            lua_remove(L, -2);
+        }
+        rc = mdbx_cursor_put(cur, k, &v, flags);
+        lua_pop(L, 1);
+        return rc;
+    }
+
+    // encode the value directly into the reserved space
+    rc = mdbx_cursor_put(cur, k, &v, flags | MDBX_RESERVE);
+    if (rc == MDBX_SUCCESS) {
+        lmdbx_msgpack_encode(L, idx, v.iov_base);
+    }
+    return rc;
+}
+
+typedef struct {
+    const unsigned char *p;
+    size_t len;
+    size_t pos;
+} msgpack_reader_t;
+
+static inline int get_be(msgpack_reader_t *r, int n, uint64_t *u64)
+{
+    if (r->len - r->pos < (size_t)n) {
+        return -1;
+    }
+    *u64 = 0;
+    for (int i = 0; i < n; i++) {
+        *u64 = (*u64 << 8) | r->p[r->pos++];
+    }
+    return 0;
+}
+
+static int decode(lua_State *L, msgpack_reader_t *r, int depth);
+
+static int decode_string(lua_State *L, msgpack_reader_t *r, size_t len)
+{
+    if (r->len - r->pos < len) {
+        return -1;
+    }
+    lua_pushlstring(L, (const char *)r->p + r->pos, len);
+    r->pos += len;
+    return 0;
+}
+
+static int decode_array(lua_State *L, msgpack_reader_t *r, size_t n,
+                        int depth)
+{
+    // each item takes at least one byte
+    if (depth >= MSGPACK_MAX_DEPTH || r->len - r->pos < n ||
+        !lua_checkstack(L, 3)) {
+        return -1;
+    }
+    lua_createtable(L, (int)n, 0);
+    for (size_t i = 1; i <= n; i++) {
+        if (decode(L, r, depth + 1)) {
+            return -1;
+        }
+        lua_rawseti(L, -2, i);
+    }
+    return 0;
+}
+
+static int decode_map(lua_State *L, msgpack_reader_t *r, size_t n, int depth)
+{
+    // each pair takes at least two bytes
+    if (depth >= MSGPACK_MAX_DEPTH || (r->len - r->pos) / 2 < n ||
+        !lua_checkstack(L, 3)) {
+        return -1;
+    }
+    lua_createtable(L, 0, (int)n);
+    for (size_t i = 0; i < n; i++) {
+        if (decode(L, r, depth + 1) || decode(L, r, depth + 1) ||
+            lua_isnil(L, -2)) {
+            return -1;
+        }
+        lua_rawset(L, -3);
+    }
+    return 0;
+}
+
+static int decode(lua_State *L, msgpack_reader_t *r, int depth)
+{
+    unsigned char code = 0;
+    uint64_t u64       = 0;
+
+    if (r->pos >= r->len) {
+        return -1;
+    }
+    code = r->p[r->pos++];
+
+    if (code <= 0x7f) {
+        lua_pushinteger(L, code);
+        return 0;
+    } else if (code >= 0xe0) {
+        lua_pushinteger(L, (lua_Integer)code - 0x100);
+        return 0;
+    } else if ((code & 0xe0) == 0xa0) {
+        return decode_string(L, r, code & 0x1f);
+    } else if ((code & 0xf0) == 0x90) {
+        return decode_array(L, r, code & 0x0f, depth);
+    } else if ((code & 0xf0) == 0x80) {
+        return decode_map(L, r, code & 0x0f, depth);
+    }
+
+    switch (code) {
+    case 0xc0:
+        lua_pushnil(L);
+        return 0;
+    case 0xc2:
+    case 0xc3:
+        lua_pushboolean(L, code == 0xc3);
+        return 0;
+
+    // uint 8/16/32/64
+    case 0xcc:
+    case 0xcd:
+    case 0xce:
+    case 0xcf:
+        if (get_be(r, 1 << (code - 0xcc), &u64)) {
+            return -1;
+        }
+        lua_pushinteger(L, (lua_Integer)u64);
+        return 0;
+
+    // int 8/16/32/64
+    case 0xd0:
+    case 0xd1:
+    case 0xd2:
+    case 0xd3: {
+        int n = 1 << (code - 0xd0);
+
+        if (get_be(r, n, &u64)) {
+            return -1;
+        } else if (n < 8 && (u64 >> (n * 8 - 1))) {
+            // sign extension
+            u64 |= UINT64_MAX << (n * 8);
+        }
+        lua_pushinteger(L, (lua_Integer)u64);
+        return 0;
+    }
+
+    // float 32/64
+    case 0xca: {
+        uint32_t u32 = 0;
+        float f      = 0;
+
+        if (get_be(r, 4, &u64)) {
+            return -1;
+        }
+        u32 = (uint32_t)u64;
+        memcpy(&f, &u32, sizeof(f));
+        lua_pushnumber(L, f);
+        return 0;
+    }
+    case 0xcb: {
+        double d = 0;
+
+        if (get_be(r, 8, &u64)) {
+            return -1;
+        }
+        memcpy(&d, &u64, sizeof(d));
+        lua_pushnumber(L, d);
+        return 0;
+    }
+
+    // str 8/16/32 and bin 8/16/32
+    case 0xd9:
+    case 0xda:
+    case 0xdb:
+        if (get_be(r, 1 << (code - 0xd9), &u64)) {
+            return -1;
+        }
+        return decode_string(L, r, u64);
+    case 0xc4:
+    case 0xc5:
+    case 0xc6:
+        if (get_be(r, 1 << (code - 0xc4), &u64)) {
+            return -1;
+        }
+        return decode_string(L, r, u64);
+
+    // array 16/32 and map 16/32
+    case 0xdc:
+    case 0xdd:
+        if (get_be(r, (code == 0xdc) ? 2 : 4, &u64)) {
+            return -1;
+        }
+        return decode_array(L, r, u64, depth);
+    case 0xde:
+    case 0xdf:
+        if (get_be(r, (code == 0xde) ? 2 : 4, &u64)) {
+            return -1;
+        }
+        return decode_map(L, r, u64, depth);
+
+    // ext types are not supported
+    default:
+        return -1;
+    }
+}
+
+int lmdbx_msgpack_decode(lua_State *L, const MDBX_val *v)
+{
+    msgpack_reader_t r = {
+        .p   = v->iov_base,
+        .len = v->iov_len,
+        .pos = 0,
+    };
+    int top = lua_gettop(L);
+
+    if (decode(L, &r, 0) || r.pos != r.len) {
+        lua_settop(L, top);
+        return MDBX_EINVAL;
+    }
+    return MDBX_SUCCESS;
+}
+
+static int encode_lua(lua_State *L)
+{
+    size_t len = 0;
+    void *buf  = NULL;
+
+    // msgpack.encode(val)
+    lua_settop(L, 1);
+    len = lmdbx_msgpack_size(L, 1);
+    buf = lua_newuserdata(L, len);
+    lmdbx_msgpack_encode(L, 1, buf);
+    lua_pushlstring(L, buf, len);
+    return 1;
+}
+
+static int decode_lua(lua_State *L)
+{
+    MDBX_val v = {0};
+
+    // msgpack.decode(s)
+    v.iov_base = (void *)lauxh_checklstring(L, 1, &v.iov_len);
+    lua_settop(L, 1);
+    if (lmdbx_msgpack_decode(L, &v)) {
+        return lauxh_argerror(L, 1, "invalid msgpack encoding");
+    }
+    return 1;
+}
+
+void lmdbx_msgpack_init(lua_State *L)
+{
+    struct luaL_Reg funcs[] = {
+        {"encode", encode_lua},
+        {"decode", decode_lua},
+        {NULL,     NULL      }
+    };
+
+    lua_newtable(L);
+    lmdbx_register(L, funcs, LUA_NOREF);
+}
@@ -0,0 +1,463 @@
+/**
+ * Copyright (C) 2023 Masatoshi Fukunaga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+#include "lmdbx.h"
+#include <stdlib.h>
+
+// a schema describes the fixed layout of a record.
+// the fields are placed without padding in the declared order, and the
+// numbers are stored in native byte order.
+//
+//  i8, i16, i32, i64 : signed integers
+//  u8, u16, u32, u64 : unsigned integers
+//  f32, f64          : floating point numbers
+//  bool              : 1 byte boolean
+//  s<N>              : N bytes string padded with 0x00
+
+int lmdbx_schema_parsetype(const char *type, lmdbx_field_t *f)
+{
+    char *end = NULL;
+    long n    = 0;
+
+    if (strcmp(type, "bool") == 0) {
+        f->type  = LMDBX_FIELD_BOOL;
+        f->width = 1;
+        return 0;
+    }
+
+    switch (*type) {
+    case 'i':
+        f->type = LMDBX_FIELD_INT;
+        break;
+    case 'u':
+        f->type = LMDBX_FIELD_UINT;
+        break;
+    case 'f':
+        f->type = LMDBX_FIELD_FLOAT;
+        break;
+    case 's':
+        f->type = LMDBX_FIELD_STRING;
+        break;
+    default:
+        return -1;
+    }
+
+    errno = 0;
+    n     = strtol(type + 1, &end, 10);
+    if (errno || *end || end == type + 1) {
+        return -1;
+    } else if (f->type == LMDBX_FIELD_STRING) {
+        if (n < 1 || n > UINT16_MAX) {
+            return -1;
+        }
+        f->width = n;
+        return 0;
+    } else if (f->type == LMDBX_FIELD_FLOAT) {
+        if (n != 32 && n != 64) {
+            return -1;
+        }
+    } else if (n != 8 && n != 16 && n != 32 && n != 64) {
+        return -1;
+    }
+    f->width = n / 8;
+    return 0;
+}
+
+lmdbx_field_t *lmdbx_schema_checkfield(lua_State *L, lmdbx_schema_t *s,
+                                       int idx)
+{
+    lua_Integer i = 0;
+
+    if (lua_type(L, idx) == LUA_TNUMBER) {
+        i = lua_tointeger(L, idx);
+    } else {
+        lauxh_checkstring(L, idx);
+        lauxh_pushref(L, s->names_ref);
+        lua_pushvalue(L, idx);
+        lua_rawget(L, -2);
+        i = lua_tointeger(L, -1);
+        lua_pop(L, 2);
+    }
+    if (i < 1 || i > s->nfield) {
+        lauxh_argerror(L, idx, "unknown field: %s", lua_tostring(L, idx));
+    }
+    return &s->fields[i - 1];
+}
+
+int lmdbx_schema_pushfield(lua_State *L, const lmdbx_field_t *f,
+                           const MDBX_val *v)
+{
+    const char *p = (const char *)v->iov_base + f->offset;
+
+    if (v->iov_len < f->offset + f->width) {
+        return MDBX_EINVAL;
+    }
+
+    switch (f->type) {
+    case LMDBX_FIELD_BOOL:
+        lua_pushboolean(L, *p != 0);
+        return MDBX_SUCCESS;
+
+    case LMDBX_FIELD_STRING: {
+        // strip the padding
+        const char *end = memchr(p, 0, f->width);
+        lua_pushlstring(L, p, (end) ? (size_t)(end - p) : f->width);
+        return MDBX_SUCCESS;
+    }
+
+    case LMDBX_FIELD_FLOAT:
+        if (f->width == sizeof(float)) {
+            float v32 = 0;
+            memcpy(&v32, p, sizeof(v32));
+            lua_pushnumber(L, v32);
+        } else {
+            double v64 = 0;
+            memcpy(&v64, p, sizeof(v64));
+            lua_pushnumber(L, v64);
+        }
+        return MDBX_SUCCESS;
+
+    default: {
+        union {
+            int8_t i8;
+            int16_t i16;
+            int32_t i32;
+            int64_t i64;
+            uint8_t u8;
+            uint16_t u16;
+            uint32_t u32;
+            uint64_t u64;
+        } n;
+        int is_signed = f->type == LMDBX_FIELD_INT;
+
+        memcpy(&n, p, f->width);
+        switch (f->width) {
+        case 1:
+            lua_pushinteger(L, (is_signed) ? n.i8 : n.u8);
+            break;
+        case 2:
+            lua_pushinteger(L, (is_signed) ? n.i16 : n.u16);
+            break;
+        case 4:
+            lua_pushinteger(L, (is_signed) ? (lua_Integer)n.i32 :
+                                             (lua_Integer)n.u32);
+            break;
+        default:
+            lua_pushinteger(L, (lua_Integer)n.i64);
+        }
+        return MDBX_SUCCESS;
+    }
+    }
+}
+
+// returns 1 if the integer can be stored in the field without truncation.
+// the 64-bit fields store any lua_Integer, the negative integers are stored
+// in the unsigned 64-bit field as the two's complement.
+static int inrange(const lmdbx_field_t *f, lua_Integer ival)
+{
+    int is_signed = f->type == LMDBX_FIELD_INT;
+
+    switch (f->width) {
+    case 1:
+        return (is_signed) ? ival >= INT8_MIN && ival <= INT8_MAX :
+                             ival >= 0 && ival <= UINT8_MAX;
+    case 2:
+        return (is_signed) ? ival >= INT16_MIN && ival <= INT16_MAX :
+                             ival >= 0 && ival <= UINT16_MAX;
+    case 4:
+        return (is_signed) ? ival >= INT32_MIN && ival <= INT32_MAX :
+                             ival >= 0 && ival <= UINT32_MAX;
+    default:
+        return 1;
+    }
+}
+
+static void packfield(lua_State *L, const lmdbx_field_t *f, int idx,
+                      char *buf)
+{
+    char *p = buf + f->offset;
+
+    switch (f->type) {
+    case LMDBX_FIELD_BOOL:
+        *p = (char)lua_toboolean(L, idx);
+        return;
+
+    case LMDBX_FIELD_STRING: {
+        size_t len    = 0;
+        const char *s = lua_tolstring(L, idx, &len);
+
+        if (len > f->width) {
+            luaL_error(L, "string length must be less than or equal to %d",
+                       (int)f->width);
+        }
+        memcpy(p, s, len);
+        return;
+    }
+
+    case LMDBX_FIELD_FLOAT:
+        if (f->width == sizeof(float)) {
+            float v32 = (float)lua_tonumber(L, idx);
+            memcpy(p, &v32, sizeof(v32));
+        } else {
+            double v64 = lua_tonumber(L, idx);
+            memcpy(p, &v64, sizeof(v64));
+        }
+        return;
+
+    default: {
+        union {
+            int8_t i8;
+            int16_t i16;
+            int32_t i32;
+            int64_t i64;
+        } n;
+        lua_Integer ival = lua_tointeger(L, idx);
+
+        switch (f->width) {
+        case 1:
+            n.i8 = (int8_t)ival;
+            break;
+        case 2:
+            n.i16 = (int16_t)ival;
+            break;
+        case 4:
+            n.i32 = (int32_t)ival;
+            break;
+        default:
+            n.i64 = (int64_t)ival;
+        }
+        memcpy(p, &n, f->width);
+        return;
+    }
+    }
+}
+
+static int pack_lua(lua_State *L)
+{
+    lmdbx_schema_t *s = lauxh_checkudata(L, 1, LMDBX_SCHEMA_MT);
+    char *buf         = NULL;
+
+    // schema:pack(tbl)
+    // the missing fields are filled with zero
+    luaL_checktype(L, 2, LUA_TTABLE);
+    lua_settop(L, 2);
+    buf = lua_newuserdata(L, s->size);
+    memset(buf, 0, s->size);
+    lauxh_pushref(L, s->names_ref);
+    for (int i = 0; i < s->nfield; i++) {
+        const lmdbx_field_t *f = &s->fields[i];
+        int t                  = LUA_TNIL;
+
+        // get the field name by index
+        lua_rawgeti(L, 4, i + 1);
+        lua_rawget(L, 2);
+        t = lua_type(L, -1);
+        if (t != LUA_TNIL) {
+            const char *expect = "integer";
+            int ok             = 0;
+
+            switch (f->type) {
+            case LMDBX_FIELD_BOOL:
+                expect = "boolean";
+                ok     = t == LUA_TBOOLEAN;
+                break;
+            case LMDBX_FIELD_STRING:
+                expect = "string";
+                ok     = t == LUA_TSTRING;
+                break;
+            case LMDBX_FIELD_FLOAT:
+                expect = "number";
+                ok     = t == LUA_TNUMBER;
+                break;
+            default:
+                ok = t == LUA_TNUMBER && lmdbx_isinteger(L, -1);
+            }
+            if (!ok) {
+                lua_rawgeti(L, 4, i + 1);
+                lauxh_argerror(L, 2, "field %s must be %s, got %s",
+                               lua_tostring(L, -1), expect,
+                               luaL_typename(L, -2));
+            } else if ((f->type == LMDBX_FIELD_INT ||
+                        f->type == LMDBX_FIELD_UINT) &&
+                       !inrange(f, lua_tointeger(L, -1))) {
+                lua_rawgeti(L, 4, i + 1);
+                lauxh_argerror(L, 2, "field %s is out of range: %s",
+                               lua_tostring(L, -1), lua_tostring(L, -2));
+            }
+            packfield(L, f, -1, buf);
+        }
+        lua_pop(L, 1);
+    }
+    lua_pushlstring(L, buf, s->size);
+    return 1;
+}
+
+static int unpack_lua(lua_State *L)
+{
+    lmdbx_schema_t *s = lauxh_checkudata(L, 1, LMDBX_SCHEMA_MT);
+    MDBX_val v        = {0};
+
+    // schema:unpack(record)
+    v.iov_base = (void *)lauxh_checklstring(L, 2, &v.iov_len);
+    if (v.iov_len < s->size) {
+        lauxh_argerror(L, 2, "record length must be at least %d",
+                       (int)s->size);
+    }
+    lua_settop(L, 2);
+    lauxh_pushref(L, s->names_ref);
+    lua_createtable(L, 0, s->nfield);
+    for (int i = 0; i < s->nfield; i++) {
+        lua_rawgeti(L, 3, i + 1);
+        lmdbx_schema_pushfield(L, &s->fields[i], &v);
+        lua_rawset(L, -3);
+    }
+    return 1;
+}
+
+static int get_lua(lua_State *L)
+{
+    lmdbx_schema_t *s      = lauxh_checkudata(L, 1, LMDBX_SCHEMA_MT);
+    size_t len             = 0;
+    const char *rec        = lauxh_checklstring(L, 2, &len);
+    const lmdbx_field_t *f = lmdbx_schema_checkfield(L, s, 3);
+    MDBX_val v             = {.iov_base = (void *)rec, .iov_len = len};
+
+    // schema:get(record, field)
+    if (lmdbx_schema_pushfield(L, f, &v)) {
+        lauxh_argerror(L, 2, "record length must be at least %d",
+                       (int)s->size);
+    }
+    return 1;
+}
+
+static int size_lua(lua_State *L)
+{
+    lmdbx_schema_t *s = lauxh_checkudata(L, 1, LMDBX_SCHEMA_MT);
+    lua_pushinteger(L, s->size);
+    return 1;
+}
+
+static int gc_lua(lua_State *L)
+{
+    lmdbx_schema_t *s = lauxh_checkudata(L, 1, LMDBX_SCHEMA_MT);
+    lauxh_unref(L, s->names_ref);
+    return 0;
+}
+
+static int tostring_lua(lua_State *L)
+{
+    lmdbx_schema_t *s = lauxh_checkudata(L, 1, LMDBX_SCHEMA_MT);
+    lua_pushfstring(L, LMDBX_SCHEMA_MT ": %p", s);
+    return 1;
+}
+
+int lmdbx_schema_new_lua(lua_State *L)
+{
+    int nfield        = 0;
+    size_t offset     = 0;
+    lmdbx_schema_t *s = NULL;
+
+    // libmdbx.schema({{name, type}, ...})
+    luaL_checktype(L, 1, LUA_TTABLE);
+    lua_settop(L, 1);
+    nfield = (int)lmdbx_rawlen(L, 1);
+    if (nfield < 1) {
+        lauxh_argerror(L, 1, "at least one field must be declared");
+    }
+
+    s = lua_newuserdata(L, sizeof(lmdbx_schema_t) +
+                               sizeof(lmdbx_field_t) * nfield);
+    s->names_ref = LUA_NOREF;
+    s->nfield    = nfield;
+    lauxh_setmetatable(L, LMDBX_SCHEMA_MT);
+
+    // the names table maps the field names to the indexes and the indexes
+    // to the field names
+    lua_createtable(L, nfield, nfield);
+    for (int i = 0; i < nfield; i++) {
+        lmdbx_field_t *f = &s->fields[i];
+
+        lua_rawgeti(L, 1, i + 1);
+        if (!lua_istable(L, -1)) {
+            lauxh_argerror(L, 1, "field#%d must be table, got %s", i + 1,
+                           luaL_typename(L, -1));
+        }
+        lua_rawgeti(L, -1, 1);
+        lua_rawgeti(L, -2, 2);
+        if (lua_type(L, -2) != LUA_TSTRING) {
+            lauxh_argerror(L, 1, "field#%d name must be string", i + 1);
+        } else if (lua_type(L, -1) != LUA_TSTRING ||
+                   lmdbx_schema_parsetype(lua_tostring(L, -1), f)) {
+            lauxh_argerror(L, 1, "field#%d type must be valid type string",
+                           i + 1);
+        }
+        lua_pop(L, 1);
+
+        // duplicate names are not allowed
+        lua_pushvalue(L, -1);
+        lua_rawget(L, 3);
+        if (!lua_isnil(L, -1)) {
+            lauxh_argerror(L, 1, "field#%d name %s is duplicated", i + 1,
+                           lua_tostring(L, -2));
+        }
+        lua_pop(L, 1);
+        lua_pushvalue(L, -1);
+        lua_rawseti(L, 3, i + 1);
+        lua_pushinteger(L, i + 1);
+        lua_rawset(L, 3);
+        lua_pop(L, 1);
+
+        f->offset = offset;
+        offset += f->width;
+    }
+    s->size      = offset;
+    s->names_ref = lauxh_ref(L);
+
+    return 1;
+}
+
+void lmdbx_schema_init(lua_State *L, int errno_ref)
+{
+    struct luaL_Reg mmethod[] = {
+        {"__tostring", tostring_lua},
+        {"__gc",       gc_lua      },
+        {NULL,         NULL        }
+    };
+    struct luaL_Reg method[] = {
+        {"size",   size_lua  },
+        {"get",    get_lua   },
+        {"pack",   pack_lua  },
+        {"unpack", unpack_lua},
+        {NULL,     NULL      }
+    };
+
+    // create metatable
+    luaL_newmetatable(L, LMDBX_SCHEMA_MT);
+    // metamethods
+    lmdbx_register(L, mmethod, errno_ref);
+    // methods
+    lua_pushstring(L, "__index");
+    lua_newtable(L);
+    lmdbx_register(L, method, errno_ref);
+    lua_rawset(L, -3);
+    lua_pop(L, 1);
+}
@@ -0,0 +1,256 @@
+/**
+ * Copyright (C) 2023 Masatoshi Fukunaga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+#include "lmdbx.h"
+
+// the tuple encoding is an order-preserving encoding of a list of values.
+// the encoded tuples compare with memcmp in the same order as the values of
+// the same type, and the encoding of a tuple is a prefix of the encoding of
+// the tuples that start with the same values.
+// integers and floating point numbers are encoded as different types, so
+// that all integers are less than any floating point number.
+//
+//  nil     : 0x00
+//  string  : 0x02 <bytes with 0x00 escaped as 0x00 0xFF> 0x00
+//  integer : 0x14 for zero,
+//            0x14 + n <n bytes big-endian> for positive integers,
+//            0x14 - n <n bytes of one's complement> for negative integers
+//  number  : 0x21 <8 bytes big-endian of the transformed IEEE 754 double>
+//  false   : 0x26
+//  true    : 0x27
+#define TUPLE_NIL    0x00
+#define TUPLE_STRING 0x02
+#define TUPLE_INT    0x14
+#define TUPLE_DOUBLE 0x21
+#define TUPLE_FALSE  0x26
+#define TUPLE_TRUE   0x27
+
+static inline void add_be64(luaL_Buffer *b, uint64_t u64, int n)
+{
+    for (int i = n - 1; i >= 0; i--) {
+        luaL_addchar(b, (char)(u64 >> (i * 8)));
+    }
+}
+
+static void add_integer(luaL_Buffer *b, lua_Integer ival)
+{
+    uint64_t u64 = (ival < 0) ? -(uint64_t)ival : (uint64_t)ival;
+    int n        = 0;
+
+    for (uint64_t v = u64; v; v >>= 8) {
+        n++;
+    }
+    if (ival < 0) {
+        // one's complement to reverse the order of the magnitude
+        luaL_addchar(b, TUPLE_INT - n);
+        add_be64(b, ~u64, n);
+        return;
+    }
+    luaL_addchar(b, TUPLE_INT + n);
+    add_be64(b, u64, n);
+}
+
+static void add_double(luaL_Buffer *b, lua_Number num)
+{
+    uint64_t u64 = 0;
+
+    memcpy(&u64, &num, sizeof(u64));
+    // flip all bits of negative numbers and the sign bit of others
+    u64 ^= (u64 >> 63) ? UINT64_MAX : (UINT64_C(1) << 63);
+    luaL_addchar(b, TUPLE_DOUBLE);
+    add_be64(b, u64, 8);
+}
+
+static void add_string(luaL_Buffer *b, const char *s, size_t len)
+{
+    size_t head = 0;
+
+    luaL_addchar(b, TUPLE_STRING);
+    for (size_t i = 0; i < len; i++) {
+        if (s[i] == 0) {
+            luaL_addlstring(b, s + head, i - head + 1);
+            luaL_addchar(b, (char)0xFF);
+            head = i + 1;
+        }
+    }
+    luaL_addlstring(b, s + head, len - head);
+    luaL_addchar(b, 0);
+}
+
+static void pack(lua_State *L, int from, int to)
+{
+    luaL_Buffer b;
+
+    luaL_buffinit(L, &b);
+    for (int idx = from; idx <= to; idx++) {
+        switch (lua_type(L, idx)) {
+        case LUA_TNIL:
+            luaL_addchar(&b, TUPLE_NIL);
+            break;
+
+        case LUA_TBOOLEAN:
+            luaL_addchar(&b,
+                         (lua_toboolean(L, idx)) ? TUPLE_TRUE : TUPLE_FALSE);
+            break;
+
+        case LUA_TNUMBER:
+            if (lmdbx_isinteger(L, idx)) {
+                add_integer(&b, lua_tointeger(L, idx));
+            } else {
+                add_double(&b, lua_tonumber(L, idx));
+            }
+            break;
+
+        case LUA_TSTRING: {
+            size_t len    = 0;
+            const char *s = lua_tolstring(L, idx, &len);
+            add_string(&b, s, len);
+        } break;
+
+        default:
+            lauxh_argerror(L, idx, "unsupported value type: %s",
+                           luaL_typename(L, idx));
+        }
+    }
+    luaL_pushresult(&b);
+}
+
+static int pack_lua(lua_State *L)
+{
+    // tuple.pack(...)
+    pack(L, 1, lua_gettop(L));
+    return 1;
+}
+
+static int range_lua(lua_State *L)
+{
+    // tuple.range(...) returns the start and stop keys of the tuples that
+    // start with the specified values.
+    // the stop key is the start key followed by 0xFF. incrementing the last
+    // byte of the start key does not work, since the string terminator 0x00
+    // followed by 0xFF is an escaped null byte of a longer string.
+    // no type code of the following value can be 0xFF.
+    pack(L, 1, lua_gettop(L));
+    lua_pushvalue(L, -1);
+    lua_pushliteral(L, "\xff");
+    lua_concat(L, 2);
+    return 2;
+}
+
+static int unpack_lua(lua_State *L)
+{
+    size_t len             = 0;
+    const char *str        = lauxh_checklstring(L, 1, &len);
+    const unsigned char *s = (const unsigned char *)str;
+    size_t pos             = 0;
+    int narg               = 0;
+
+    // tuple.unpack(s)
+    lua_settop(L, 1);
+    while (pos < len) {
+        unsigned char code = s[pos++];
+
+        luaL_checkstack(L, 1, "too many values in the tuple");
+        if (code == TUPLE_NIL) {
+            lua_pushnil(L);
+        } else if (code == TUPLE_FALSE || code == TUPLE_TRUE) {
+            lua_pushboolean(L, code == TUPLE_TRUE);
+        } else if (code == TUPLE_DOUBLE) {
+            uint64_t u64   = 0;
+            lua_Number num = 0;
+
+            if (len - pos < 8) {
+                goto INVALID;
+            }
+            for (int i = 0; i < 8; i++) {
+                u64 = (u64 << 8) | s[pos++];
+            }
+            u64 ^= (u64 >> 63) ? (UINT64_C(1) << 63) : UINT64_MAX;
+            memcpy(&num, &u64, sizeof(num));
+            lua_pushnumber(L, num);
+        } else if (code >= TUPLE_INT - 8 && code <= TUPLE_INT + 8) {
+            int neg      = code < TUPLE_INT;
+            int n        = (neg) ? TUPLE_INT - code : code - TUPLE_INT;
+            uint64_t u64 = 0;
+
+            if (len - pos < (size_t)n) {
+                goto INVALID;
+            }
+            for (int i = 0; i < n; i++) {
+                u64 = (u64 << 8) | s[pos++];
+            }
+            if (neg) {
+                // restore the magnitude from the one's complement
+                u64 = ~u64;
+                if (n < 8) {
+                    u64 &= (UINT64_C(1) << (n * 8)) - 1;
+                }
+                lua_pushinteger(L, (lua_Integer)(-u64));
+            } else {
+                lua_pushinteger(L, (lua_Integer)u64);
+            }
+        } else if (code == TUPLE_STRING) {
+            luaL_Buffer b;
+            size_t head = pos;
+
+            luaL_buffinit(L, &b);
+            while (1) {
+                if (pos >= len) {
+                    goto INVALID;
+                } else if (s[pos] == 0) {
+                    luaL_addlstring(&b, str + head, pos - head);
+                    if (pos + 1 < len && s[pos + 1] == 0xFF) {
+                        // escaped null byte
+                        luaL_addchar(&b, 0);
+                        pos += 2;
+                        head = pos;
+                        continue;
+                    }
+                    pos++;
+                    break;
+                }
+                pos++;
+            }
+            luaL_pushresult(&b);
+        } else {
+            goto INVALID;
+        }
+        narg++;
+    }
+    return narg;
+
+INVALID:
+    return lauxh_argerror(L, 1, "invalid tuple encoding at %d", (int)pos);
+}
+
+void lmdbx_tuple_init(lua_State *L)
+{
+    struct luaL_Reg funcs[] = {
+        {"pack",   pack_lua  },
+        {"unpack", unpack_lua},
+        {"range",  range_lua },
+        {NULL,     NULL      }
+    };
+
+    lua_newtable(L);
+    lmdbx_register(L, funcs, LUA_NOREF);
+}
@@ -54,6 +54,8 @@ static int renew_lua(lua_State *L)
     lmdbx_txn_t *txn = lauxh_checkudata(L, 1, LMDBX_TXN_MT);
     int rc           = mdbx_txn_renew(txn->txn);
 
+    txn->gen++;
+    txn->epoch++;
     if (rc) {
         lua_pushboolean(L, 0);
         lmdbx_pusherror(L, rc);
@@ -68,6 +70,8 @@ static int reset_lua(lua_State *L)
     lmdbx_txn_t *txn = lauxh_checkudata(L, 1, LMDBX_TXN_MT);
     int rc           = mdbx_txn_reset(txn->txn);
 
+    txn->gen++;
+    txn->epoch++;
     if (rc) {
         lua_pushboolean(L, 0);
         lmdbx_pusherror(L, rc);
@@ -97,10 +101,12 @@ static inline int exec_txn(lua_State *L, int doas)
         rc = mdbx_txn_break(txn->txn);
         break;
     }
+    txn->gen++;
 
     if (txn->txn && doas != EXEC_AS_BREAK) {
         txn->env_ref = lauxh_unref(L, txn->env_ref);
         txn->txn     = NULL;
+        txn->epoch++;
     }
 
     if (rc == MDBX_THREAD_MISMATCH) {
@@ -253,6 +259,10 @@ static int begin_lua(lua_State *L)
     lauxh_setmetatable(L, LMDBX_TXN_MT);
     lauxh_pushref(L, txn->env_ref);
     child->env_ref = lauxh_ref(L);
+    child->gen     = 0;
+    child->epoch   = 0;
+    // changes made by the child transaction will be merged into the parent
+    txn->gen++;
 
     return 1;
 }
@@ -324,6 +334,8 @@ int lmdbx_txn_begin_lua(lua_State *L)
     }
     lauxh_setmetatable(L, LMDBX_TXN_MT);
     txn->env_ref = lauxh_refat(L, 1);
+    txn->gen     = 0;
+    txn->epoch   = 0;
 
     return 1;
 }
@@ -0,0 +1,358 @@
+/**
+ * Copyright (C) 2023 Masatoshi Fukunaga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ **/
+
+#include "lmdbx.h"
+#include <errno.h>
+#include <unistd.h>
+
+static inline lmdbx_view_t *checkview(lua_State *L, int idx)
+{
+    lmdbx_view_t *view = lauxh_checkudata(L, idx, LMDBX_VIEW_MT);
+
+    // the memory referenced by view is only valid until the next update
+    // operation or the end of the transaction.
+    if (!view->txn || !view->txn->txn || view->gen != view->txn->gen) {
+        luaL_error(L, "attempt to access an invalidated " LMDBX_VIEW_MT);
+    }
+    return view;
+}
+
+static inline lmdbx_view_t *checkwritable(lua_State *L, int idx)
+{
+    lmdbx_view_t *view = checkview(L, idx);
+
+    if (!view->writable) {
+        luaL_error(L, "attempt to write to a read-only " LMDBX_VIEW_MT);
+    }
+    return view;
+}
+
+// check the 1-based position to write n bytes and return its offset
+static inline size_t checkwritepos(lua_State *L, int idx, lmdbx_view_t *view,
+                                   size_t n)
+{
+    lua_Integer pos = lauxh_optinteger(L, idx, 1);
+
+    if (pos < 1 || (size_t)pos - 1 > view->len ||
+        n > view->len - ((size_t)pos - 1)) {
+        lauxh_argerror(L, idx, "out of range");
+    }
+    return (size_t)pos - 1;
+}
+
+static inline const char *checkbytes(lua_State *L, int idx, size_t *len)
+{
+    if (lauxh_ismetatableof(L, idx, LMDBX_VIEW_MT)) {
+        lmdbx_view_t *view = checkview(L, idx);
+        *len               = view->len;
+        return view->ptr;
+    }
+    return lauxh_checklstring(L, idx, len);
+}
+
+static inline size_t posrelat(lua_Integer pos, size_t len)
+{
+    if (pos >= 0) {
+        return (size_t)pos;
+    } else if ((size_t)-pos > len) {
+        return 0;
+    }
+    return len + (size_t)pos + 1;
+}
+
+static inline int compare(const char *a, size_t alen, const char *b,
+                          size_t blen)
+{
+    int rv = memcmp(a, b, (alen < blen) ? alen : blen);
+
+    if (rv == 0) {
+        return (alen < blen) ? -1 : (alen > blen);
+    }
+    return (rv < 0) ? -1 : 1;
+}
+
+static int compare_lua(lua_State *L)
+{
+    size_t alen   = 0;
+    const char *a = checkbytes(L, 1, &alen);
+    size_t blen   = 0;
+    const char *b = checkbytes(L, 2, &blen);
+
+    lua_pushinteger(L, compare(a, alen, b, blen));
+    return 1;
+}
+
+static int byte_lua(lua_State *L)
+{
+    lmdbx_view_t *view = checkview(L, 1);
+    size_t i           = posrelat(lauxh_optinteger(L, 2, 1), view->len);
+    size_t j           = posrelat(lauxh_optinteger(L, 3, i), view->len);
+    int n              = 0;
+
+    if (i < 1) {
+        i = 1;
+    }
+    if (j > view->len) {
+        j = view->len;
+    }
+    if (i > j) {
+        return 0;
+    }
+    n = (int)(j - i + 1);
+    luaL_checkstack(L, n, "string slice too long");
+    for (; i <= j; i++) {
+        lua_pushinteger(L, (unsigned char)view->ptr[i - 1]);
+    }
+    return n;
+}
+
+static int sub_lua(lua_State *L)
+{
+    lmdbx_view_t *view = checkview(L, 1);
+    size_t i           = posrelat(lauxh_checkinteger(L, 2), view->len);
+    size_t j           = posrelat(lauxh_optinteger(L, 3, -1), view->len);
+    MDBX_val v         = {.iov_base = (void *)view->ptr, .iov_len = 0};
+
+    if (i < 1) {
+        i = 1;
+    }
+    if (j > view->len) {
+        j = view->len;
+    }
+    if (i <= j) {
+        v.iov_base = (void *)(view->ptr + i - 1);
+        v.iov_len  = j - i + 1;
+    }
+    lmdbx_view_new(L, view->txn_ref, view->txn, &v);
+    // the sub view of a writable view is also writable
+    ((lmdbx_view_t *)lua_touserdata(L, -1))->writable = view->writable;
+    return 1;
+}
+
+static int read_fd_lua(lua_State *L)
+{
+    lmdbx_view_t *view = checkwritable(L, 1);
+    int fd             = (int)lauxh_checkinteger(L, 2);
+    size_t off         = checkwritepos(L, 3, view, 0);
+    lua_Integer n      = lauxh_optinteger(L, 4, view->len - off);
+    char *ptr          = (char *)view->ptr + off;
+    size_t nread       = 0;
+
+    // view:read_fd(fd [, pos [, n]])
+    if (n < 0 || (size_t)n > view->len - off) {
+        lauxh_argerror(L, 4, "out of range");
+    }
+    while (nread < (size_t)n) {
+        ssize_t rv = read(fd, ptr + nread, (size_t)n - nread);
+
+        if (rv > 0) {
+            nread += rv;
+        } else if (rv == 0) {
+            break;
+        } else if (errno != EINTR) {
+            lua_pushnil(L);
+            lmdbx_pusherror(L, (errno == EINVAL) ? MDBX_EINVAL : MDBX_EIO);
+            lua_pushinteger(L, nread);
+            return 3;
+        }
+    }
+    lua_pushinteger(L, nread);
+    return 1;
+}
+
+static int write_int_lua(lua_State *L)
+{
+    lmdbx_view_t *view = checkwritable(L, 1);
+    lua_Integer ival   = lauxh_checkinteger(L, 2);
+    lua_Integer size   = lauxh_optinteger(L, 3, sizeof(int64_t));
+    size_t off         = 0;
+    union {
+        uint8_t u8;
+        uint16_t u16;
+        uint32_t u32;
+        int64_t i64;
+    } buf;
+
+    // view:write_int(ival [, size [, pos]])
+    // write an integer in native byte order
+    switch (size) {
+    case 1:
+        buf.u8 = (uint8_t)ival;
+        break;
+    case 2:
+        buf.u16 = (uint16_t)ival;
+        break;
+    case 4:
+        buf.u32 = (uint32_t)ival;
+        break;
+    case 8:
+        buf.i64 = (int64_t)ival;
+        break;
+    default:
+        lauxh_argerror(L, 3, "size must be 1, 2, 4 or 8");
+    }
+    off = checkwritepos(L, 4, view, size);
+    memcpy((char *)view->ptr + off, &buf, size);
+    // returns the next position
+    lua_pushinteger(L, off + size + 1);
+    return 1;
+}
+
+static int write_lua(lua_State *L)
+{
+    lmdbx_view_t *view = checkwritable(L, 1);
+    size_t len         = 0;
+    const char *data   = checkbytes(L, 2, &len);
+    size_t off         = checkwritepos(L, 3, view, len);
+
+    // view:write(data [, pos])
+    // data may be a view that overlaps this view
+    memmove((char *)view->ptr + off, data, len);
+    // returns the next position
+    lua_pushinteger(L, off + len + 1);
+    return 1;
+}
+
+static int is_writable_lua(lua_State *L)
+{
+    lmdbx_view_t *view = lauxh_checkudata(L, 1, LMDBX_VIEW_MT);
+    lua_pushboolean(L, view->writable);
+    return 1;
+}
+
+static int len_lua(lua_State *L)
+{
+    lmdbx_view_t *view = checkview(L, 1);
+    lua_pushinteger(L, view->len);
+    return 1;
+}
+
+static int tostring_lua(lua_State *L)
+{
+    lmdbx_view_t *view = checkview(L, 1);
+    lua_pushlstring(L, view->ptr, view->len);
+    return 1;
+}
+
+static int is_valid_lua(lua_State *L)
+{
+    lmdbx_view_t *view = lauxh_checkudata(L, 1, LMDBX_VIEW_MT);
+    lua_pushboolean(L, view->txn && view->txn->txn &&
+                           view->gen == view->txn->gen);
+    return 1;
+}
+
+static int le_lua(lua_State *L)
+{
+    size_t alen   = 0;
+    const char *a = checkbytes(L, 1, &alen);
+    size_t blen   = 0;
+    const char *b = checkbytes(L, 2, &blen);
+
+    lua_pushboolean(L, compare(a, alen, b, blen) <= 0);
+    return 1;
+}
+
+static int lt_lua(lua_State *L)
+{
+    size_t alen   = 0;
+    const char *a = checkbytes(L, 1, &alen);
+    size_t blen   = 0;
+    const char *b = checkbytes(L, 2, &blen);
+
+    lua_pushboolean(L, compare(a, alen, b, blen) < 0);
+    return 1;
+}
+
+static int eq_lua(lua_State *L)
+{
+    size_t alen   = 0;
+    const char *a = checkbytes(L, 1, &alen);
+    size_t blen   = 0;
+    const char *b = checkbytes(L, 2, &blen);
+
+    lua_pushboolean(L, compare(a, alen, b, blen) == 0);
+    return 1;
+}
+
+static int gc_lua(lua_State *L)
+{
+    lmdbx_view_t *view = lauxh_checkudata(L, 1, LMDBX_VIEW_MT);
+
+    view->txn_ref = lauxh_unref(L, view->txn_ref);
+    view->txn     = NULL;
+    return 0;
+}
+
+void lmdbx_view_new(lua_State *L, int txn_ref, lmdbx_txn_t *txn,
+                    const MDBX_val *v)
+{
+    lmdbx_view_t *view = lua_newuserdata(L, sizeof(lmdbx_view_t));
+
+    view->txn_ref  = LUA_NOREF;
+    view->txn      = txn;
+    view->gen      = txn->gen;
+    view->ptr      = v->iov_base;
+    view->len      = v->iov_len;
+    view->writable = 0;
+    lauxh_setmetatable(L, LMDBX_VIEW_MT);
+    // keep the transaction alive while the view is referenced
+    lauxh_pushref(L, txn_ref);
+    view->txn_ref = lauxh_ref(L);
+}
+
+void lmdbx_view_init(lua_State *L, int errno_ref)
+{
+    struct luaL_Reg mmethod[] = {
+        {"__tostring", tostring_lua},
+        {"__len",      len_lua     },
+        {"__eq",       eq_lua      },
+        {"__lt",       lt_lua      },
+        {"__le",       le_lua      },
+        {"__gc",       gc_lua      },
+        {NULL,         NULL        }
+    };
+    struct luaL_Reg method[] = {
+        {"is_valid",    is_valid_lua   },
+        {"is_writable", is_writable_lua},
+        {"tostring",    tostring_lua   },
+        {"len",         len_lua        },
+        {"sub",         sub_lua        },
+        {"byte",        byte_lua       },
+        {"compare",     compare_lua    },
+        {"write",       write_lua      },
+        {"write_int",   write_int_lua  },
+        {"read_fd",     read_fd_lua    },
+        {NULL,          NULL           }
+    };
+
+    // create metatable
+    luaL_newmetatable(L, LMDBX_VIEW_MT);
+    // metamethods
+    lmdbx_register(L, mmethod, errno_ref);
+    // methods
+    lua_pushstring(L, "__index");
+    lua_newtable(L);
+    lmdbx_register(L, method, errno_ref);
+    lua_rawset(L, -3);
+    lua_pop(L, 1);
+}
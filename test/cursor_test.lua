@@ -45,12 +45,52 @@ function testcase.txn()
     assert.equal(cur:txn(), dbh:txn())
 end
 
+function testcase.viewmode()
+    local dbh = opendbh()
+    assert(dbh:put('foo', 'foo-value'))
+    dbh:viewmode(true)
+    local cur = assert(dbh:cursor_open())
+
+    -- test that inherit the viewmode of dbh
+    assert.is_true(cur:viewmode())
+    local k, v = assert(cur:get_first())
+    assert.equal(k:tostring(), 'foo')
+    assert.equal(v:tostring(), 'foo-value')
+
+    -- test that return strings
+    assert.is_true(cur:viewmode(false))
+    k, v = assert(cur:get_first())
+    assert.equal(k, 'foo')
+    assert.equal(v, 'foo-value')
+end
+
 function testcase.close()
     local dbh = opendbh()
     local cur = assert(dbh:cursor_open())
 
     -- test that close a cursor handle
     cur:close()
+
+    -- test that write methods return EINVAL error after the transaction
+    -- referenced by the closed cursor is collected
+    dbh = nil
+    collectgarbage()
+    collectgarbage()
+    local ok, err = cur:put('foo', 'bar')
+    assert.is_false(ok)
+    assert.equal(err, libmdbx.errno.EINVAL)
+    ok, err = cur:del()
+    assert.is_false(ok)
+    assert.equal(err, libmdbx.errno.EINVAL)
+    ok, err = cur:put_obj('foo', {})
+    assert.is_false(ok)
+    assert.equal(err, libmdbx.errno.EINVAL)
+    local n
+    n, err = cur:put_multiple('foo', {
+        1,
+    })
+    assert.is_nil(n)
+    assert.equal(err, libmdbx.errno.EINVAL)
 end
 
 function testcase.renew()
@@ -516,6 +556,92 @@ function testcase.get()
     })
 end
 
+function testcase.get_multiple()
+    local dbh = opendbh(nil, libmdbx.DUPSORT, libmdbx.DUPFIXED, libmdbx.CREATE)
+    assert(dbh:put('foo', '\1\1\1\1'))
+    assert(dbh:put('foo', '\2\2\2\2'))
+    assert(dbh:put('foo', '\3\3\3\3'))
+    assert(dbh:put('qux', 'qux1'))
+    local cur = assert(dbh:cursor_open())
+
+    -- test that retrieve packed fixed-size values of the current key
+    assert(cur:set('foo'))
+    local k, v = assert(cur:get_multiple())
+    assert.equal(k, 'foo')
+    assert.equal(v, '\1\1\1\1\2\2\2\2\3\3\3\3')
+
+    -- test that decode packed values into integer array
+    k, v = assert(cur:get_multiple(true))
+    assert.equal(k, 'foo')
+    assert.equal(v, {
+        0x01010101,
+        0x02020202,
+        0x03030303,
+    })
+
+    -- test that return nil if no more values of the current key
+    k, v = cur:next_multiple()
+    assert.is_nil(k)
+    assert.is_nil(v)
+
+    -- test that retrieve values of the next key
+    assert(cur:get_next_nodup())
+    k, v = assert(cur:get_multiple())
+    assert.equal(k, 'qux')
+    assert.equal(v, 'qux1')
+
+    -- test that return an error if the cursor is not positioned
+    cur = assert(dbh:cursor_open())
+    local err
+    k, v, err = cur:get_multiple()
+    assert.is_nil(k)
+    assert.is_nil(v)
+    assert(err)
+
+    -- test that next_multiple starts from the first key
+    k, v = assert(cur:next_multiple())
+    assert.equal(k, 'foo')
+    assert.equal(v, '\1\1\1\1\2\2\2\2\3\3\3\3')
+    assert(dbh:txn():commit())
+
+    -- test that return the packed values of INTEGERDUP database as string
+    -- even if its size is the same as an integer
+    local env = assert(libmdbx.new())
+    assert(env:set_maxdbs(2))
+    assert(env:open(PATHNAME .. '.int', nil, libmdbx.NOSUBDIR))
+    local txn = assert(env:begin())
+    for name, vals in pairs({
+        int64 = {
+            1,
+        },
+        int32 = {
+            '\1\0\0\0',
+            '\2\0\0\0',
+        },
+    }) do
+        local dbi = assert(txn:dbi_open(name, libmdbx.DUPSORT,
+                                        libmdbx.DUPFIXED, libmdbx.INTEGERDUP,
+                                        libmdbx.CREATE))
+        dbh = assert(dbi:dbh_open(txn))
+        for _, val in ipairs(vals) do
+            assert(dbh:put('foo', val))
+        end
+        cur = assert(dbh:cursor_open())
+        assert(cur:set('foo'))
+        k, v = assert(cur:get_multiple())
+        assert.equal(k, 'foo')
+        if name == 'int64' then
+            assert.equal(v, '\1\0\0\0\0\0\0\0')
+        else
+            assert.equal(v, '\1\0\0\0\2\0\0\0')
+        end
+    end
+    txn:abort()
+    env:close()
+    os.remove(PATHNAME .. '.int')
+    os.remove(PATHNAME .. '.int' .. libmdbx.LOCK_SUFFIX)
+end
+
 function testcase.get_batch()
     local dbh = opendbh()
     assert(dbh:put('foo', 'foo-value'))
@@ -532,6 +658,719 @@ function testcase.get_batch()
     })
 end
 
+function testcase.range()
+    local dbh = opendbh()
+    for _, k in ipairs({
+        'a',
+        'b',
+        'c',
+        'd',
+        'e',
+    }) do
+        assert(dbh:put(k, k .. '-value'))
+    end
+    local cur = assert(dbh:cursor_open())
+    local function collect(...)
+        local keys = {}
+        for k, v in assert(cur:range(...)) do
+            assert.equal(v, k .. '-value')
+            keys[#keys + 1] = k
+        end
+        return keys
+    end
+
+    -- test that iterate all items
+    assert.equal(collect(), {
+        'a',
+        'b',
+        'c',
+        'd',
+        'e',
+    })
+
+    -- test that iterate items in [start, stop)
+    assert.equal(collect('b', 'd'), {
+        'b',
+        'c',
+    })
+
+    -- test that bounds can be inclusive or exclusive
+    assert.equal(collect('b', 'd', {
+        start_inclusive = false,
+        stop_inclusive = true,
+    }), {
+        'c',
+        'd',
+    })
+
+    -- test that iterate items in reverse order
+    assert.equal(collect('b', 'd', {
+        reverse = true,
+    }), {
+        'c',
+        'b',
+    })
+    assert.equal(collect(nil, 'cc', {
+        reverse = true,
+        limit = 2,
+    }), {
+        'c',
+        'b',
+    })
+    assert.equal(collect('b', 'd', {
+        reverse = true,
+        start_inclusive = false,
+        stop_inclusive = true,
+    }), {
+        'd',
+        'c',
+    })
+
+    -- test that stop iteration when limit reached
+    assert.equal(collect('b', nil, {
+        limit = 2,
+    }), {
+        'b',
+        'c',
+    })
+
+    -- test that return no items if range is empty
+    assert.equal(collect('x'), {})
+    assert.equal(collect('c', 'c'), {})
+
+    -- test that throws an error if invalid option
+    local err = assert.throws(cur.range, cur, nil, nil, {
+        limit = 'foo',
+    })
+    assert.match(err, 'field \'limit\' must be integer')
+end
+
+function testcase.range_prefix()
+    local dbh = opendbh()
+    local tuple = libmdbx.tuple
+    for _, k in ipairs({
+        tuple.pack('foo', 1),
+        tuple.pack('foo', 2, 'a'),
+        tuple.pack('foo', 2, 'b'),
+        tuple.pack('foo', 3),
+        tuple.pack('bar', 2),
+    }) do
+        assert(dbh:put(k, 'value'))
+    end
+    local cur = assert(dbh:cursor_open())
+    local function collect(...)
+        local list = {}
+        for k in assert(cur:range_prefix(...)) do
+            list[#list + 1] = {
+                tuple.unpack(k),
+            }
+        end
+        return list
+    end
+
+    -- test that iterate items that start with the prefix
+    assert.equal(collect(tuple.pack('foo', 2)), {
+        {
+            'foo',
+            2,
+            'a',
+        },
+        {
+            'foo',
+            2,
+            'b',
+        },
+    })
+
+    -- test that iterate items in reverse order
+    assert.equal(collect(tuple.pack('foo'), {
+        reverse = true,
+    }), {
+        {
+            'foo',
+            3,
+        },
+        {
+            'foo',
+            2,
+            'b',
+        },
+        {
+            'foo',
+            2,
+            'a',
+        },
+        {
+            'foo',
+            1,
+        },
+    })
+
+    -- test that iterate nothing if no key starts with the prefix
+    assert.equal(collect(tuple.pack('baz')), {})
+end
+
+function testcase.range_filter()
+    local dbh = opendbh()
+    local s = assert(libmdbx.schema({
+        {
+            'id',
+            'u32',
+        },
+        {
+            'score',
+            'i16',
+        },
+        {
+            'ratio',
+            'f64',
+        },
+    }))
+    assert(dbh:put('a:1', s:pack({
+        id = 1,
+        score = -5,
+        ratio = 0.5,
+    })))
+    assert(dbh:put('a:2', s:pack({
+        id = 2,
+        score = 10,
+        ratio = 1.5,
+    })))
+    assert(dbh:put('a:3', 'hello world'))
+    assert(dbh:put('b:1', 'hello'))
+    local cur = assert(dbh:cursor_open())
+    local function collect(iter)
+        local list = {}
+        for k in iter do
+            list[#list + 1] = k
+        end
+        return list
+    end
+
+    -- test that iterate items that match the length bounds
+    assert.equal(collect(cur:range(nil, nil, {
+        filter = {
+            minlen = 6,
+            maxlen = 11,
+        },
+    })), {
+        'a:3',
+    })
+
+    -- test that iterate items that contain the bytes
+    assert.equal(collect(cur:range_prefix('a:', {
+        filter = {
+            contains = 'world',
+        },
+    })), {
+        'a:3',
+    })
+    assert.equal(collect(cur:range(nil, nil, {
+        filter = {
+            contains = 'hello',
+        },
+    })), {
+        'a:3',
+        'b:1',
+    })
+
+    -- test that iterate items that match the integer comparisons
+    assert.equal(collect(cur:range(nil, nil, {
+        filter = {
+            minlen = s:size(),
+            {
+                type = 'i16',
+                offset = 4,
+                op = '<',
+                value = 0,
+            },
+        },
+    })), {
+        'a:1',
+    })
+    assert.equal(collect(cur:range(nil, nil, {
+        filter = {
+            {
+                type = 'u32',
+                offset = 0,
+                op = '>=',
+                value = 1,
+            },
+            {
+                type = 'f64',
+                offset = 6,
+                op = '>',
+                value = 1.0,
+            },
+        },
+    })), {
+        'a:2',
+    })
+
+    -- test that limit counts only the matched items
+    assert.equal(collect(cur:range(nil, nil, {
+        limit = 1,
+        filter = {
+            contains = 'hello',
+        },
+    })), {
+        'a:3',
+    })
+
+    -- test that throws an error if filter is invalid
+    local err = assert.throws(cur.range, cur, nil, nil, {
+        filter = {
+            {
+                type = 's8',
+                op = '==',
+                value = 1,
+            },
+        },
+    })
+    assert.match(err, 'filter#1 type must be integer or floating point')
+    err = assert.throws(cur.range, cur, nil, nil, {
+        filter = {
+            {
+                type = 'u8',
+                op = '=',
+                value = 1,
+            },
+        },
+    })
+    assert.match(err, 'filter#1 op must be comparison operator')
+end
+
+function testcase.range_for_dupsort()
+    local dbh = opendbh(nil, libmdbx.DUPSORT, libmdbx.CREATE)
+    for _, kv in ipairs({
+        {
+            'a',
+            '1',
+        },
+        {
+            'b',
+            '1',
+        },
+        {
+            'b',
+            '2',
+        },
+        {
+            'c',
+            '1',
+        },
+    }) do
+        assert(dbh:put(kv[1], kv[2]))
+    end
+    local cur = assert(dbh:cursor_open())
+
+    -- test that iterate all duplicates of the stop key in reverse order
+    local res = {}
+    for k, v in assert(cur:range('a', 'b', {
+        reverse = true,
+        stop_inclusive = true,
+    })) do
+        res[#res + 1] = k .. v
+    end
+    assert.equal(res, {
+        'b2',
+        'b1',
+        'a1',
+    })
+end
+
+function testcase.get_batch_list()
+    local dbh = opendbh(nil, libmdbx.DUPSORT, libmdbx.CREATE)
+    assert(dbh:put('foo', 'foo-value'))
+    assert(dbh:put('bar', 'bar-value1'))
+    assert(dbh:put('bar', 'bar-value2'))
+    assert(dbh:put('qux', 'qux-value'))
+    local cur = assert(dbh:cursor_open())
+
+    -- test that retrieve key/value pairs in order into arrays
+    local keys, vals, eof = assert(cur:get_batch_list(3))
+    assert.equal(keys, {
+        'bar',
+        'bar',
+        'foo',
+    })
+    assert.equal(vals, {
+        'bar-value1',
+        'bar-value2',
+        'foo-value',
+    })
+    assert.is_false(eof)
+
+    -- test that reuse the passed arrays and remove stale items
+    local k2, v2
+    k2, v2, eof = assert(cur:get_batch_list(3, nil, keys, vals))
+    assert.equal(k2, keys)
+    assert.equal(v2, vals)
+    assert.equal(keys, {
+        'qux',
+    })
+    assert.equal(vals, {
+        'qux-value',
+    })
+    assert.is_true(eof)
+
+    -- test that return empty arrays if no more items
+    keys, vals, eof = assert(cur:get_batch_list(3, nil, keys, vals))
+    assert.equal(keys, {})
+    assert.equal(vals, {})
+    assert.is_true(eof)
+
+    -- test that retrieve items in reverse order
+    keys, vals, eof = assert(cur:get_batch_list(2, libmdbx.LAST))
+    assert.equal(keys, {
+        'qux',
+        'foo',
+    })
+    assert.equal(vals, {
+        'qux-value',
+        'foo-value',
+    })
+    assert.is_false(eof)
+    keys, _, eof = assert(cur:get_batch_list(2, libmdbx.PREV))
+    assert.equal(keys, {
+        'bar',
+        'bar',
+    })
+    assert.is_true(eof)
+end
+
+function testcase.get_batch_list_eof_with_dupsort()
+    local dbh = opendbh(nil, libmdbx.DUPSORT, libmdbx.CREATE)
+    assert(dbh:put('a', 'a1'))
+    assert(dbh:put('a', 'a2'))
+    assert(dbh:put('b', 'b1'))
+    assert(dbh:put('b', 'b2'))
+    local cur = assert(dbh:cursor_open())
+
+    -- test that eof is false while the last key has duplicates left
+    local op = libmdbx.FIRST
+    for _, exp in ipairs({
+        'a1',
+        'a2',
+        'b1',
+        'b2',
+    }) do
+        local _, vals, eof = assert(cur:get_batch_list(1, op))
+        assert.equal(vals, {
+            exp,
+        })
+        assert.equal(eof, exp == 'b2')
+        op = libmdbx.NEXT
+    end
+
+    -- test that eof is false while the first key has duplicates left
+    op = libmdbx.LAST
+    for _, exp in ipairs({
+        'b2',
+        'b1',
+        'a2',
+        'a1',
+    }) do
+        local _, vals, eof = assert(cur:get_batch_list(1, op))
+        assert.equal(vals, {
+            exp,
+        })
+        assert.equal(eof, exp == 'a1')
+        op = libmdbx.PREV
+    end
+
+    -- test that NODUP op skips the duplicates of all keys in the batch
+    cur = assert(dbh:cursor_open())
+    local keys, vals, eof = assert(cur:get_batch_list(10, libmdbx.NEXT_NODUP))
+    assert.equal(keys, {
+        'a',
+        'b',
+    })
+    assert.equal(vals, {
+        'a1',
+        'b1',
+    })
+    assert.is_true(eof)
+    assert(cur:set('b'))
+    keys, vals, eof = assert(cur:get_batch_list(10, libmdbx.PREV_NODUP))
+    assert.equal(keys, {
+        'a',
+    })
+    assert.equal(vals, {
+        'a2',
+    })
+    assert.is_true(eof)
+
+    -- test that DUP op stays in the duplicates of the current key
+    assert(cur:set('a'))
+    keys, vals, eof = assert(cur:get_batch_list(10, libmdbx.NEXT_DUP))
+    assert.equal(keys, {
+        'a',
+    })
+    assert.equal(vals, {
+        'a2',
+    })
+    assert.is_true(eof)
+end
+
+function testcase.project()
+    local dbh = opendbh()
+    local s = assert(libmdbx.schema({
+        {
+            'id',
+            'u32',
+        },
+        {
+            'score',
+            'f64',
+        },
+        {
+            'flag',
+            'bool',
+        },
+    }))
+    for i = 1, 5 do
+        assert(dbh:put('key' .. i, s:pack({
+            id = i,
+            score = i / 2,
+            flag = i % 2 == 0,
+        })))
+    end
+    local cur = assert(dbh:cursor_open())
+
+    -- test that project the fields of the records into columns
+    local keys, cols, eof = assert(cur:project(s, {
+        'score',
+        'id',
+    }, 3, libmdbx.FIRST))
+    assert.equal(keys, {
+        'key1',
+        'key2',
+        'key3',
+    })
+    assert.equal(cols, {
+        {
+            0.5,
+            1,
+            1.5,
+        },
+        {
+            1,
+            2,
+            3,
+        },
+    })
+    assert.is_false(eof)
+
+    -- test that continue from the current position
+    keys, cols, eof = assert(cur:project(s, {
+        'flag',
+    }, 3))
+    assert.equal(keys, {
+        'key4',
+        'key5',
+    })
+    assert.equal(cols, {
+        {
+            true,
+            false,
+        },
+    })
+    assert.is_true(eof)
+end
+
+function testcase.join_batch()
+    local env = assert(libmdbx.new())
+    assert(env:set_maxdbs(2))
+    assert(env:open(PATHNAME, nil, libmdbx.NOSUBDIR))
+    local txn = assert(env:begin())
+    local dbi = assert(txn:dbi_open('ids', libmdbx.DUPSORT, libmdbx.CREATE))
+    local ids = assert(dbi:dbh_open(txn))
+    dbi = assert(txn:dbi_open('recs', libmdbx.CREATE))
+    local recs = assert(dbi:dbh_open(txn))
+    for i = 1, 100 do
+        assert(recs:put(string.format('id%03d', i), 'rec' .. i))
+    end
+    for _, i in ipairs({
+        2,
+        3,
+        50,
+        99,
+        150,
+    }) do
+        assert(ids:put(string.format('id%03d', i), 'x'))
+    end
+    assert(ids:put('id003', 'y'))
+    local lcur = assert(ids:cursor_open())
+    local rcur = assert(recs:cursor_open())
+    assert(lcur:get_first())
+    assert(rcur:get_first())
+
+    -- test that read the matched items up to the limit
+    local keys, lvals, rvals, eof = lcur:join_batch(rcur, 3)
+    assert.equal(keys, {
+        'id002',
+        'id003',
+        'id003',
+    })
+    assert.equal(lvals, {
+        'x',
+        'x',
+        'y',
+    })
+    assert.equal(rvals, {
+        'rec2',
+        'rec3',
+        'rec3',
+    })
+    assert.is_false(eof)
+
+    -- test that continue the join from the next item
+    keys, lvals, rvals, eof = lcur:join_batch(rcur)
+    assert.equal(keys, {
+        'id050',
+        'id099',
+    })
+    assert.equal(rvals, {
+        'rec50',
+        'rec99',
+    })
+    assert.is_true(eof)
+
+    -- test that return empty tables after eof
+    keys, lvals, rvals, eof = lcur:join_batch(rcur)
+    assert.equal(keys, {})
+    assert.is_true(eof)
+end
+
+function testcase.position_token()
+    local dbh = opendbh()
+    for _, k in ipairs({
+        'a',
+        'b',
+        'c',
+        'd',
+    }) do
+        assert(dbh:put(k, k .. '-value'))
+    end
+    local cur = assert(dbh:cursor_open())
+
+    -- test that return nothing if cursor is not positioned
+    assert.is_nil(cur:position_token())
+
+    -- test that resume from the next item of the token
+    assert.equal({
+        cur:set_range('b'),
+    }, {
+        'b',
+        'b-value',
+    })
+    local token = assert(cur:position_token())
+    cur = assert(dbh:cursor_open())
+    assert.equal({
+        cur:resume(token),
+    }, {
+        'c',
+        'c-value',
+    })
+
+    -- test that resume from the previous item of the token
+    assert.equal({
+        cur:resume(token, true),
+    }, {
+        'a',
+        'a-value',
+    })
+
+    -- test that resume from the next key if the key has been deleted
+    assert(dbh:del('b'))
+    assert.equal(cur:resume(token), 'c')
+    assert.equal(cur:resume(token, true), 'a')
+
+    -- test that return nothing if no more items
+    assert(cur:set_range('d'))
+    assert.is_nil(cur:resume(assert(cur:position_token())))
+
+    -- test that return EINVAL error if token is malformed
+    local k, v, err = cur:resume('foo')
+    assert.is_nil(k)
+    assert.is_nil(v)
+    assert.equal(err, libmdbx.errno.EINVAL)
+
+    -- test that return EINVAL error if token without value has trailing
+    -- bytes
+    k, v, err = cur:resume(token .. 'x')
+    assert.is_nil(k)
+    assert.is_nil(v)
+    assert.equal(err, libmdbx.errno.EINVAL)
+end
+
+function testcase.position_token_for_dupsort()
+    local dbh = opendbh(nil, libmdbx.DUPSORT, libmdbx.CREATE)
+    for _, kv in ipairs({
+        {
+            'a',
+            '1',
+        },
+        {
+            'b',
+            '1',
+        },
+        {
+            'b',
+            '2',
+        },
+        {
+            'b',
+            '3',
+        },
+        {
+            'c',
+            '1',
+        },
+    }) do
+        assert(dbh:put(kv[1], kv[2]))
+    end
+    local cur = assert(dbh:cursor_open())
+    local function resume(token, reverse)
+        return {
+            cur:resume(token, reverse),
+        }
+    end
+
+    -- test that resume from the next duplicate of the token
+    assert(cur:get_both('b', '2'))
+    local token = assert(cur:position_token())
+    assert.equal(resume(token), {
+        'b',
+        '3',
+    })
+    assert.equal(resume(token, true), {
+        'b',
+        '1',
+    })
+
+    -- test that resume from the next item if the duplicate has been deleted
+    assert(dbh:del('b', '2'))
+    assert.equal(resume(token), {
+        'b',
+        '3',
+    })
+    assert.equal(resume(token, true), {
+        'b',
+        '1',
+    })
+    assert(dbh:del('b', '3'))
+    assert.equal(resume(token), {
+        'c',
+        '1',
+    })
+    assert.equal(resume(token, true), {
+        'b',
+        '1',
+    })
+end
+
 function testcase.put()
     local dbh = opendbh()
     assert(dbh:put('foo', 'foo-value'))
@@ -555,6 +1394,127 @@ function testcase.put()
     assert.equal(err, libmdbx.errno.EKEYMISMATCH)
 end
 
+function testcase.put_get_integer()
+    local dbh = opendbh(nil, libmdbx.INTEGERKEY, libmdbx.CREATE)
+    local cur = assert(dbh:cursor_open())
+
+    -- test that put and get items by integer keys
+    for i = 1, 3 do
+        assert.is_true(cur:put(i * 100, 'value-' .. i))
+    end
+    assert.equal({
+        cur:set_range(150),
+    }, {
+        200,
+        'value-2',
+    })
+    assert.equal({
+        cur:get_last(),
+    }, {
+        300,
+        'value-3',
+    })
+    assert.equal(cur:set(100), 'value-1')
+
+    -- test that a non-integer value is not decoded as an integer
+    assert.is_true(cur:put(400, '12345678'))
+    assert.equal(cur:set(400), '12345678')
+end
+
+function testcase.put_get_obj()
+    local dbh = opendbh()
+    local cur = assert(dbh:cursor_open())
+
+    -- test that store tables and get them
+    assert.is_true(cur:put_obj('foo', {
+        foo = 1,
+    }))
+    assert.is_true(cur:put_obj('bar', {
+        bar = 2,
+    }))
+    local k, v = cur:get_obj(libmdbx.FIRST)
+    assert.equal(k, 'bar')
+    assert.equal(v, {
+        bar = 2,
+    })
+    k, v = cur:get_obj(libmdbx.SET_KEY, 'foo')
+    assert.equal(k, 'foo')
+    assert.equal(v, {
+        foo = 1,
+    })
+end
+
+function testcase.put_multiple()
+    local dbh = opendbh(nil, libmdbx.DUPSORT, libmdbx.DUPFIXED,
+                        libmdbx.INTEGERDUP, libmdbx.CREATE)
+    local cur = assert(dbh:cursor_open())
+
+    -- test that put multiple integer values for the key
+    local values = {}
+    for i = 1, 1000 do
+        values[i] = i
+    end
+    assert.equal(cur:put_multiple('foo', values), 1000)
+    assert(cur:set('foo'))
+    assert.equal(cur:count(), 1000)
+    local res = {}
+    local _, list = assert(cur:get_multiple(true))
+    while list do
+        for _, v in ipairs(list) do
+            res[#res + 1] = v
+        end
+        _, list = cur:next_multiple(true)
+    end
+    assert.equal(res, values)
+
+    -- test that put packed values
+    assert.equal(cur:put_multiple('bar', '\1\1\1\1\2\2\2\2', 4), 2)
+    assert(cur:set('bar'))
+    _, list = assert(cur:get_multiple(true))
+    assert.equal(list, {
+        0x01010101,
+        0x02020202,
+    })
+
+    -- test that throws an error if invalid arguments
+    local err = assert.throws(cur.put_multiple, cur, 'foo', '\1\1\1', 4)
+    assert.match(err, 'length must be a multiple of 4')
+    err = assert.throws(cur.put_multiple, cur, 'foo', {
+        'foo',
+    })
+    assert.match(err, 'item#1 must be integer')
+    assert(dbh:txn():commit())
+
+    -- test that integers are packed to the size of the existing values of
+    -- INTEGERDUP database by default
+    local env = assert(libmdbx.new())
+    assert(env:set_maxdbs(1))
+    assert(env:open(PATHNAME .. '.int', nil, libmdbx.NOSUBDIR))
+    local txn = assert(env:begin())
+    local dbi = assert(txn:dbi_open('int32', libmdbx.DUPSORT, libmdbx.DUPFIXED,
+                                    libmdbx.INTEGERDUP, libmdbx.CREATE))
+    assert(assert(dbi:dbh_open(txn)):put('foo', '\1\0\0\0'))
+    assert(txn:commit())
+    txn = assert(env:begin())
+    dbi = assert(txn:dbi_open('int32'))
+    cur = assert(assert(dbi:dbh_open(txn)):cursor_open())
+    assert.equal(cur:put_multiple('foo', {
+        2,
+        3,
+    }), 2)
+    assert(cur:set('foo'))
+    _, list = assert(cur:get_multiple(true))
+    assert.equal(list, {
+        1,
+        2,
+        3,
+    })
+    txn:abort()
+    env:close()
+    os.remove(PATHNAME .. '.int')
+    os.remove(PATHNAME .. '.int' .. libmdbx.LOCK_SUFFIX)
+end
+
 function testcase.del()
     local dbh = opendbh(nil, libmdbx.DUPSORT, libmdbx.CREATE)
     assert(dbh:put('foo', 'foo-value-1'))
@@ -56,6 +56,26 @@ function testcase.txn()
     assert.equal(dbh:txn(), txn)
 end
 
+function testcase.viewmode()
+    local dbh = opendbh()
+    assert(dbh:put('foo', 'bar'))
+
+    -- test that return a string by default
+    assert.is_false(dbh:viewmode())
+    assert.equal(dbh:get('foo'), 'bar')
+
+    -- test that return a view of value
+    assert.is_false(dbh:viewmode(true))
+    assert.is_true(dbh:viewmode())
+    local v = assert(dbh:get('foo'))
+    assert.match(v, '^bar$', false)
+    assert.equal(v:tostring(), 'bar')
+
+    -- test that view is invalidated by update operation
+    assert(dbh:put('foo', 'baz'))
+    assert.is_false(v:is_valid())
+end
+
 function testcase.close()
     local dbh = opendbh()
 
@@ -90,6 +110,57 @@ function testcase.dupsort_depthmask()
     assert.equal(dbh:dupsort_depthmask(), 0)
 end
 
+function testcase.get_many()
+    local dbh = opendbh()
+    assert(dbh:put('foo', 'foo-value'))
+    assert(dbh:put('bar', 'bar-value'))
+    assert(dbh:put('qux', 'qux-value'))
+
+    -- test that get values of keys in the original order
+    local res = assert(dbh:get_many({
+        'qux',
+        'baz',
+        'foo',
+        'bar',
+        'qux',
+    }))
+    assert.equal(res, {
+        [1] = 'qux-value',
+        [3] = 'foo-value',
+        [4] = 'bar-value',
+        [5] = 'qux-value',
+    })
+
+    -- test that return empty table
+    assert.equal(dbh:get_many({}), {})
+
+    -- test that throws an error if key is not string
+    local err = assert.throws(dbh.get_many, dbh, {
+        'foo',
+        true,
+    })
+    assert.match(err, 'item#2 must be string')
+end
+
+function testcase.exists_many()
+    local dbh = opendbh()
+    assert(dbh:put('foo', 'foo-value'))
+    assert(dbh:put('bar', 'bar-value'))
+
+    -- test that return boolean array
+    assert.equal(dbh:exists_many({
+        'qux',
+        'foo',
+        'baz',
+        'bar',
+    }), {
+        false,
+        true,
+        false,
+        true,
+    })
+end
+
 function testcase.flags()
     local dbh =
         opendbh(nil, libmdbx.DUPSORT, libmdbx.CREATE, libmdbx.REVERSEKEY)
@@ -128,6 +199,198 @@ function testcase.put_get()
     assert.equal(count, 2)
 end
 
+function testcase.put_get_integer()
+    local dbh = opendbh(nil, libmdbx.INTEGERKEY, libmdbx.DUPSORT,
+                        libmdbx.DUPFIXED, libmdbx.INTEGERDUP, libmdbx.CREATE)
+
+    -- test that store items with integer keys and values
+    assert(dbh:put(256, 2))
+    assert(dbh:put(256, 1))
+    assert(dbh:put(1, 10))
+    assert(dbh:put_many({
+        [3] = 30,
+    }))
+
+    -- test that get an integer value by integer key
+    assert.equal(dbh:get(256), 1)
+    assert.equal(dbh:get(3), 30)
+    assert.equal(dbh:get_many({
+        1,
+        3,
+        2,
+    }), {
+        10,
+        30,
+    })
+
+    -- test that iterates items in the numeric order of keys
+    local list = {}
+    for k, v in dbh:range() do
+        list[#list + 1] = {
+            k,
+            v,
+        }
+    end
+    assert.equal(list, {
+        {
+            1,
+            10,
+        },
+        {
+            3,
+            30,
+        },
+        {
+            256,
+            1,
+        },
+        {
+            256,
+            2,
+        },
+    })
+
+    -- test that integer keys can be specified as the range bounds
+    list = {}
+    for k in dbh:range(2, 256) do
+        list[#list + 1] = k
+    end
+    assert.equal(list, {
+        3,
+    })
+end
+
+function testcase.put_get_integer_4bytes()
+    local env = openenv()
+    local txn = assert(env:begin())
+    local dbi = assert(txn:dbi_open('int32', libmdbx.INTEGERKEY,
+                                    libmdbx.CREATE))
+    local dbh = assert(dbi:dbh_open(txn))
+    -- 4-byte integer key in the little-endian byte order
+    assert(dbh:put('\1\0\0\0', 'foo'))
+    assert(txn:commit())
+
+    -- test that the integers are packed to the size of the existing keys
+    txn = assert(env:begin())
+    dbi = assert(txn:dbi_open('int32'))
+    dbh = assert(dbi:dbh_open(txn))
+    assert.equal(dbh:get(1), 'foo')
+    assert(dbh:put(2, 'bar'))
+    assert.equal(dbh:get('\2\0\0\0'), 'bar')
+    local list = {}
+    for k, v in dbh:range() do
+        list[#list + 1] = {
+            k,
+            v,
+        }
+    end
+    assert.equal(list, {
+        {
+            1,
+            'foo',
+        },
+        {
+            2,
+            'bar',
+        },
+    })
+
+    -- test that throws an error if the integer does not fit in 4 bytes
+    local err = assert.throws(dbh.put, dbh, 0x100000000, 'baz')
+    assert.match(err, '4-byte integer database')
+    err = assert.throws(dbh.get, dbh, -1)
+    assert.match(err, '4-byte integer database')
+end
+
+function testcase.put_many()
+    local dbh = opendbh()
+    assert(dbh:put('bar', 'bar-value'))
+
+    -- test that put key/value pairs of table
+    assert.equal(dbh:put_many({
+        foo = 'foo-value',
+        qux = 'qux-value',
+        baa = 'baa-value',
+    }, true), 3)
+    local res = {}
+    for k, v in assert(dbh:range()) do
+        res[#res + 1] = k .. '=' .. v
+    end
+    assert.equal(res, {
+        'baa=baa-value',
+        'bar=bar-value',
+        'foo=foo-value',
+        'qux=qux-value',
+    })
+
+    -- test that put key/value pairs returned by iterator
+    local i = 0
+    assert.equal(dbh:put_many(function()
+        i = i + 1
+        if i <= 3 then
+            return 'z' .. i, 'z-value' .. i
+        end
+    end), 3)
+    assert.equal(dbh:get('z1'), 'z-value1')
+    assert.equal(dbh:get('z3'), 'z-value3')
+
+    -- test that pass flags to put
+    local n, err = dbh:put_many({
+        zz = 'zz-value',
+        foo = 'foo-value',
+    }, true, libmdbx.NOOVERWRITE)
+    assert.is_nil(n)
+    assert.equal(err, libmdbx.errno.KEYEXIST)
+    assert.equal(dbh:get('zz'), nil)
+
+    -- test that throws an error if value is not string
+    err = assert.throws(dbh.put_many, dbh, {
+        foo = 1,
+    })
+    assert.match(err, 'value must be string')
+end
+
+function testcase.put_many_for_dupsort()
+    local dbh = opendbh(nil, libmdbx.DUPSORT, libmdbx.CREATE)
+    local list = {
+        {
+            'a',
+            '1',
+        },
+        {
+            'a',
+            '2',
+        },
+        {
+            'b',
+            '1',
+        },
+        {
+            'a',
+            '0',
+        },
+    }
+    local i = 0
+
+    -- test that put duplicate values
+    assert.equal(dbh:put_many(function()
+        i = i + 1
+        if list[i] then
+            return list[i][1], list[i][2]
+        end
+    end, true), 4)
+    local res = {}
+    for k, v in assert(dbh:range()) do
+        res[#res + 1] = k .. v
+    end
+    assert.equal(res, {
+        'a0',
+        'a1',
+        'a2',
+        'b1',
+    })
+end
+
 function testcase.op_insert()
     local dbh = opendbh()
 
@@ -215,6 +478,84 @@ function testcase.op_upsert_for_dupsort()
     })
 end
 
+function testcase.op_upsert_many()
+    local dbh = opendbh(nil, libmdbx.DUPSORT, libmdbx.CREATE)
+    assert(dbh:op_upsert('foo', 'foo-1', true))
+    assert(dbh:op_upsert('foo', 'foo-2', true))
+
+    -- test that upsert values for keys
+    assert.equal(dbh:op_upsert_many({
+        foo = 'foo-value',
+        bar = 'bar-value',
+    }), 2)
+    assert.equal(dbh:get('foo', true), 'foo-value')
+    local _, _, count = dbh:get('foo', true)
+    assert.equal(count, 1)
+    assert.equal(dbh:get('bar'), 'bar-value')
+
+    -- test that add values for keys
+    assert.equal(dbh:op_upsert_many({
+        foo = 'foo-value2',
+    }, true), 1)
+    _, _, count = dbh:get('foo', true)
+    assert.equal(count, 2)
+
+    -- test that return an error after the transaction is terminated
+    assert(dbh:txn():commit())
+    local n, err = dbh:op_upsert_many({
+        foo = 'foo-value',
+    })
+    assert.is_nil(n)
+    assert(err)
+end
+
+function testcase.incr()
+    local dbh = opendbh()
+
+    -- test that store initial + delta if key does not exist
+    assert.equal(dbh:incr('foo', 1), 1)
+    assert.equal(dbh:incr('bar', 5, 100), 105)
+
+    -- test that add delta to the stored value
+    assert.equal(dbh:incr('foo', 10), 11)
+    assert.equal(dbh:incr('foo', -20, 100), -9)
+    assert.equal(#dbh:get('foo'), 8)
+
+    -- test that increment values for keys
+    assert.equal(dbh:incr_many({
+        foo = 9,
+        baz = 3,
+    }), 2)
+    assert.equal(dbh:incr('foo', 0), 0)
+    assert.equal(dbh:incr('baz', 0), 3)
+
+    -- test that return BAD_VALSIZE error if value is not 8 bytes
+    assert(dbh:put('qux', 'value'))
+    local v, err = dbh:incr('qux', 1)
+    assert.is_nil(v)
+    assert.equal(err, libmdbx.errno.BAD_VALSIZE)
+    local n
+    n, err = dbh:incr_many({
+        qux = 1,
+    })
+    assert.is_nil(n)
+    assert.equal(err, libmdbx.errno.BAD_VALSIZE)
+
+    -- test that throws an error if delta is not integer
+    err = assert.throws(dbh.incr_many, dbh, {
+        foo = 'bar',
+    })
+    assert.match(err, 'delta must be integer')
+
+    -- test that return INCOMPATIBLE error for the dupsort database
+    local txn = dbh:txn()
+    local dbi = assert(txn:dbi_open('dup', libmdbx.DUPSORT, libmdbx.CREATE))
+    dbh = assert(dbi:dbh_open(txn))
+    v, err = dbh:incr('foo', 1)
+    assert.is_nil(v)
+    assert.equal(err, libmdbx.errno.INCOMPATIBLE)
+end
+
 function testcase.op_update()
     local dbh = opendbh(nil, libmdbx.DUPSORT, libmdbx.CREATE)
     assert(dbh:put('hello', 'world'))
@@ -235,6 +576,215 @@ function testcase.op_update()
     assert.is_nil(err)
 end
 
+function testcase.reserve()
+    local dbh = opendbh()
+
+    -- test that reserve space for value and return a writable view
+    local v = assert(dbh:reserve('foo', 5))
+    assert.is_true(v:is_writable())
+    assert.equal(#v, 5)
+    v:write('hello')
+    assert.equal(dbh:get('foo'), 'hello')
+
+    -- test that throws an error if size is negative
+    local err = assert.throws(dbh.reserve, dbh, 'foo', -1)
+    assert.match(err, 'size must be greater than or equal to 0')
+end
+
+function testcase.put_get_obj()
+    local dbh = opendbh()
+
+    -- test that store a table and get it
+    local obj = {
+        name = 'foo',
+        tags = {
+            'a',
+            'b',
+        },
+        count = 3,
+    }
+    assert.is_true(dbh:put_obj('foo', obj))
+    assert.equal(dbh:get_obj('foo'), obj)
+    assert.equal(dbh:get('foo'), libmdbx.msgpack.encode(obj))
+
+    -- test that return nothing if key does not exist
+    assert.is_nil(dbh:get_obj('bar'))
+
+    -- test that return error if value is not encoded
+    assert(dbh:put('bar', '\193'))
+    local v, err = dbh:get_obj('bar')
+    assert.is_nil(v)
+    assert.equal(err, libmdbx.errno.EINVAL)
+
+    -- test that store a table into the dupsort database
+    local txn = dbh:txn()
+    local dbi = assert(txn:dbi_open('dup', libmdbx.DUPSORT, libmdbx.CREATE))
+    dbh = assert(dbi:dbh_open(txn))
+    assert.is_true(dbh:put_obj('foo', {
+        1,
+    }))
+    assert.is_true(dbh:put_obj('foo', {
+        2,
+    }))
+    assert.equal(dbh:get_obj('foo'), {
+        1,
+    })
+end
+
+function testcase.get_field()
+    local dbh = opendbh()
+    local s = assert(libmdbx.schema({
+        {
+            'count',
+            'u64',
+        },
+        {
+            'ts',
+            'i64',
+        },
+    }))
+    assert(dbh:put('foo', s:pack({
+        count = 10,
+        ts = 12345,
+    })))
+    assert(dbh:put('bar', 'short'))
+
+    -- test that get a field of the record
+    assert.equal(dbh:get_field('foo', s, 'count'), 10)
+    assert.equal(dbh:get_field('foo', s, 'ts'), 12345)
+
+    -- test that return nothing if key does not exist
+    assert.is_nil(dbh:get_field('baz', s, 'ts'))
+
+    -- test that return error if record is too short
+    local v, err = dbh:get_field('bar', s, 'ts')
+    assert.is_nil(v)
+    assert.equal(err, libmdbx.errno.EINVAL)
+end
+
+function testcase.compress()
+    local txn = opentxn()
+    local dbi = assert(txn:dbi_open('foo', libmdbx.CREATE, {
+        compress = 64,
+    }))
+    local dbh = assert(dbi:dbh_open(txn))
+    local large = string.rep('hello world ', 100)
+
+    -- test that values are compressed and decompressed transparently
+    assert(dbh:put('large', large))
+    assert(dbh:put('small', 'bar'))
+    assert.equal(dbh:get('large'), large)
+    assert.equal(dbh:get('small'), 'bar')
+    assert.is_true(dbh:put_obj('obj', {
+        value = large,
+    }))
+    assert.equal(dbh:get_obj('obj'), {
+        value = large,
+    })
+    local res = {}
+    for k, v in assert(dbh:range()) do
+        res[k] = v
+    end
+    assert.equal(res.large, large)
+    assert.equal(res.small, 'bar')
+    assert.equal(assert(dbh:replace('small', large)), 'bar')
+    assert.equal(dbh:get('small'), large)
+
+    -- test that return a view of the uncompressed value
+    assert(dbh:put('small', 'bar'))
+    dbh:viewmode(true)
+    assert.equal(dbh:get('small'):tostring(), 'bar')
+    assert.equal(dbh:get('large'), large)
+    dbh:viewmode(false)
+
+    -- test that the dbi that is already open keeps the compression setting
+    assert.equal(assert(txn:dbi_open('foo')), dbi)
+    assert.equal(assert(txn:dbi_open('foo', {
+        compress = 64,
+    })), dbi)
+    assert.equal(dbh:get('large'), large)
+    assert.equal(dbh:get('small'), 'bar')
+
+    -- test that return INCOMPATIBLE error if the setting is changed
+    local _, err = txn:dbi_open('foo', {
+        compress = 0,
+    })
+    assert.equal(err, libmdbx.errno.INCOMPATIBLE)
+
+    -- test that values are stored as is but still decoded if compress is 0
+    local bar = assert(assert(txn:dbi_open('bar', libmdbx.CREATE, {
+        compress = 0,
+    })):dbh_open(txn))
+    assert(bar:put('large', large))
+    assert.equal(bar:get('large'), large)
+    bar:close()
+    dbh:close()
+
+    -- test that the persisted setting is used if the option is not given
+    local env = txn:env()
+    assert(txn:commit())
+    env:close()
+    txn = opentxn()
+    dbh = assert(assert(txn:dbi_open('foo')):dbh_open(txn))
+    assert.equal(dbh:get('large'), large)
+    assert.equal(dbh:get('small'), 'bar')
+    _, err = txn:dbi_open('foo', {
+        compress = 32,
+    })
+    assert.equal(err, libmdbx.errno.INCOMPATIBLE)
+
+    -- test that return INCOMPATIBLE error if the database that has the
+    -- values without the header is opened with the option
+    local plain = assert(txn:dbi_open('plain', libmdbx.CREATE))
+    assert(assert(plain:dbh_open(txn)):put('foo', 'bar'))
+    _, err = txn:dbi_open('plain', {
+        compress = 64,
+    })
+    assert.equal(err, libmdbx.errno.INCOMPATIBLE)
+
+    -- test that return INCOMPATIBLE error for the main database
+    _, err = txn:dbi_open(nil, {
+        compress = 64,
+    })
+    assert.equal(err, libmdbx.errno.INCOMPATIBLE)
+
+    -- test that the setting is deleted with the database
+    local main = assert(assert(txn:dbi_open()):dbh_open(txn))
+    assert.equal(main:get('lmdbx.compress:bar'), '\0\0\0\0\0\0\0\0')
+    bar = assert(assert(txn:dbi_open('bar')):dbh_open(txn))
+    assert(bar:drop(true))
+    assert.is_nil(main:get('lmdbx.compress:bar'))
+
+    -- test that return error if the compressed value is corrupted
+    local setting = assert(main:get('lmdbx.compress:foo'))
+    assert(main:del('lmdbx.compress:foo'))
+    dbh:close()
+    env = txn:env()
+    assert(txn:commit())
+    env:close()
+    txn = opentxn()
+    dbh = assert(assert(txn:dbi_open('foo')):dbh_open(txn))
+    assert(dbh:put('large', '\1\255\255\0\0'))
+    dbh:close()
+    main = assert(assert(txn:dbi_open()):dbh_open(txn))
+    assert(main:put('lmdbx.compress:foo', setting))
+    env = txn:env()
+    assert(txn:commit())
+    env:close()
+    txn = opentxn()
+    dbh = assert(assert(txn:dbi_open('foo')):dbh_open(txn))
+    local v
+    v, err = dbh:get('large')
+    assert.is_nil(v)
+    assert.equal(err, libmdbx.errno.CORRUPTED)
+    local cur = assert(dbh:cursor_open())
+    local k
+    k, v, err = cur:get_first()
+    assert.is_nil(k)
+    assert.is_nil(v)
+    assert.equal(err, libmdbx.errno.CORRUPTED)
+end
+
 function testcase.replace()
     local dbh = opendbh()
     assert(dbh:put('hello', 'world'))
@@ -250,6 +800,28 @@ function testcase.replace()
     assert(old, err)
     assert.equal(old, '')
     assert.equal(dbh:get('bar'), 'baz')
+
+    -- test that return a large old value
+    local large = string.rep('x', 1024 * 1024 * 4)
+    assert(dbh:put('large', large))
+    old, err = dbh:replace('large', 'small')
+    assert(old, err)
+    assert.equal(old, large)
+    old = assert(dbh:replace('large', 'small2'))
+    assert.equal(old, 'small')
+end
+
+function testcase.op_replace()
+    local dbh = opendbh()
+    assert(dbh:put('hello', 'world'))
+
+    -- test that replace value without returning the old value
+    assert.is_true(dbh:op_replace('hello', 'foo'))
+    assert.equal(dbh:get('hello'), 'foo')
+
+    -- test that return false if not found
+    assert.is_false(dbh:op_replace('bar', 'baz', nil, libmdbx.CURRENT))
+    assert.is_nil(dbh:get('bar'))
 end
 
 function testcase.del()
@@ -273,6 +845,87 @@ function testcase.del()
     assert.equal(dbh:get('qux'), 'quux')
 end
 
+function testcase.del_range()
+    local dbh = opendbh(nil, libmdbx.DUPSORT, libmdbx.CREATE)
+    local function keys()
+        local res = {}
+        for k in dbh:range() do
+            res[#res + 1] = k
+        end
+        return res
+    end
+    for _, k in ipairs({
+        'a',
+        'b',
+        'c',
+        'd',
+        'e',
+        'f',
+    }) do
+        assert(dbh:put(k, k .. '-1'))
+    end
+    assert(dbh:put('b', 'b-2'))
+
+    -- test that delete all items of keys in the range
+    local n, more = dbh:del_range('b', 'd')
+    assert.equal(n, 3)
+    assert.is_false(more)
+    assert.equal(keys(), {
+        'a',
+        'd',
+        'e',
+        'f',
+    })
+
+    -- test that delete keys up to the limit
+    n, more = dbh:del_range('d', nil, {
+        start_inclusive = false,
+        limit = 1,
+    })
+    assert.equal(n, 1)
+    assert.is_true(more)
+    assert.equal(keys(), {
+        'a',
+        'd',
+        'f',
+    })
+
+    -- test that delete keys including the stop key
+    n, more = dbh:del_range(nil, 'd', {
+        stop_inclusive = true,
+    })
+    assert.equal(n, 2)
+    assert.is_false(more)
+    assert.equal(keys(), {
+        'f',
+    })
+
+    -- test that return 0 if no keys in the range
+    n, more = dbh:del_range('x')
+    assert.equal(n, 0)
+    assert.is_false(more)
+end
+
+function testcase.del_prefix()
+    local dbh = opendbh()
+    assert(dbh:put('user:1', 'foo'))
+    assert(dbh:put('user:2', 'bar'))
+    assert(dbh:put('user;', 'baz'))
+    assert(dbh:put('\255\255', 'qux'))
+
+    -- test that delete keys that start with the prefix
+    local n, more = dbh:del_prefix('user:')
+    assert.equal(n, 2)
+    assert.is_false(more)
+    assert.is_nil(dbh:get('user:1'))
+    assert.equal(dbh:get('user;'), 'baz')
+
+    -- test that delete keys if the prefix has no successor
+    n = dbh:del_prefix('\255')
+    assert.equal(n, 1)
+    assert.is_nil(dbh:get('\255\255'))
+end
+
 function testcase.cursor_open()
     local dbh = opendbh()
 
@@ -281,6 +934,183 @@ function testcase.cursor_open()
     assert.match(cur, '^libmdbx.cursor: ', false)
 end
 
+function testcase.range()
+    local dbh = opendbh()
+    assert(dbh:put('foo', 'foo-value'))
+    assert(dbh:put('bar', 'bar-value'))
+    assert(dbh:put('qux', 'qux-value'))
+
+    -- test that iterate key/value pairs in the range via a new cursor
+    local res = {}
+    for k, v in assert(dbh:range('bar', 'qux')) do
+        res[#res + 1] = k .. '=' .. v
+    end
+    assert.equal(res, {
+        'bar=bar-value',
+        'foo=foo-value',
+    })
+end
+
+function testcase.range_prefix()
+    local dbh = opendbh()
+    for _, k in ipairs({
+        'foo',
+        'foo/a',
+        'foo/b',
+        'foo\255',
+        'fop',
+    }) do
+        assert(dbh:put(k, 'value'))
+    end
+
+    -- test that iterate items that start with the prefix
+    local keys = {}
+    for k in assert(dbh:range_prefix('foo/')) do
+        keys[#keys + 1] = k
+    end
+    assert.equal(keys, {
+        'foo/a',
+        'foo/b',
+    })
+
+    -- test that the prefix that ends with 0xff is handled
+    keys = {}
+    for k in assert(dbh:range_prefix('foo\255')) do
+        keys[#keys + 1] = k
+    end
+    assert.equal(keys, {
+        'foo\255',
+    })
+end
+
+function testcase.aggregate()
+    local dbh = opendbh()
+    local s = assert(libmdbx.schema({
+        {
+            'id',
+            'u32',
+        },
+        {
+            'delta',
+            'i16',
+        },
+        {
+            'ratio',
+            'f64',
+        },
+    }))
+    for i = 1, 5 do
+        assert(dbh:put('k' .. i, s:pack({
+            id = i,
+            delta = 3 - i,
+            ratio = i / 2,
+        })))
+    end
+
+    -- test that count items in the range
+    assert.equal({
+        dbh:aggregate(),
+    }, {
+        5,
+        5,
+    })
+    assert.equal({
+        dbh:aggregate('k2', 'k4'),
+    }, {
+        2,
+        2,
+    })
+
+    -- test that aggregate the numbers specified by the type and offset
+    assert.equal({
+        dbh:aggregate(nil, nil, {
+            op = 'sum',
+            type = 'u32',
+        }),
+    }, {
+        15,
+        5,
+    })
+    assert.equal(dbh:aggregate(nil, 'k5', {
+        op = 'min',
+        type = 'i16',
+        offset = 4,
+        stop_inclusive = true,
+    }), -2)
+
+    -- test that aggregate the field of the schema
+    assert.equal(dbh:aggregate('k1', nil, {
+        op = 'max',
+        schema = s,
+        field = 'ratio',
+        start_inclusive = false,
+    }), 2.5)
+    assert.equal(dbh:aggregate(nil, nil, {
+        op = 'sum',
+        schema = s,
+        field = 'delta',
+    }), 0)
+
+    -- test that return nil if no values to compare
+    assert.equal({
+        dbh:aggregate('x', nil, {
+            op = 'min',
+            type = 'u32',
+        }),
+    }, {
+        nil,
+        0,
+    })
+
+    -- test that return BAD_VALSIZE error if value is too short
+    assert(dbh:put('k6', 'x'))
+    local v, err = dbh:aggregate(nil, nil, {
+        op = 'sum',
+        type = 'u32',
+    })
+    assert.is_nil(v)
+    assert.equal(err, libmdbx.errno.BAD_VALSIZE)
+
+    -- test that throws an error if op is unknown
+    err = assert.throws(dbh.aggregate, dbh, nil, nil, {
+        op = 'avg',
+    })
+    assert.match(err, "field 'op' must be count, sum, min or max")
+end
+
+function testcase.aggregate_dupfixed()
+    local dbh = opendbh(nil, libmdbx.DUPSORT, libmdbx.DUPFIXED,
+                        libmdbx.INTEGERDUP, libmdbx.CREATE)
+    local sum = 0
+    for i = 1, 3000 do
+        local k = 'k' .. (i % 3)
+        assert(dbh:put(k, i - 1000))
+        if k ~= 'k2' then
+            sum = sum + i - 1000
+        end
+    end
+
+    -- test that aggregate the values fetched by pages
+    assert.equal({
+        dbh:aggregate(nil, 'k2', {
+            op = 'sum',
+            type = 'i64',
+        }),
+    }, {
+        sum,
+        2000,
+    })
+    assert.equal(dbh:aggregate(nil, nil, {
+        op = 'min',
+        type = 'i64',
+    }), -999)
+    assert.equal(dbh:aggregate(nil, nil, {
+        op = 'max',
+        type = 'i64',
+    }), 2000)
+    assert.equal(dbh:aggregate(), 3000)
+end
+
 function testcase.estimate_range()
     local dbh = opendbh()
     assert(dbh:put('hello', 'world'))
@@ -308,6 +1138,57 @@ function testcase.estimate_range()
     end
 end
 
+function testcase.split_range()
+    local dbh = opendbh()
+    for i = 1, 1000 do
+        assert(dbh:put(string.format('key%04d', i), 'value'))
+    end
+    local function counts(start, stop, splits)
+        local list = {}
+        for i = 1, #splits + 1 do
+            list[i] = dbh:aggregate(splits[i - 1] or start, splits[i] or stop)
+        end
+        return list
+    end
+
+    -- test that split the range into ranges of roughly equal items
+    local splits = assert(dbh:split_range(nil, nil, 4))
+    assert.equal(#splits, 3)
+    for _, n in ipairs(counts(nil, nil, splits)) do
+        assert.is_true(n > 150 and n < 350)
+    end
+
+    -- test that split keys are in the range
+    splits = assert(dbh:split_range('key0101', 'key0301', 2))
+    assert.equal(#splits, 1)
+    assert.is_true(splits[1] > 'key0101' and splits[1] < 'key0301')
+    local list = counts('key0101', 'key0301', splits)
+    assert.is_true(list[1] > 50 and list[1] < 150)
+
+    -- test that return no keys if n is 1
+    assert.equal(dbh:split_range(nil, nil, 1), {})
+
+    -- test that split the range of integer keys
+    local txn = dbh:txn()
+    local dbi = assert(txn:dbi_open('int', libmdbx.INTEGERKEY, libmdbx.CREATE))
+    dbh = assert(dbi:dbh_open(txn))
+    assert.equal(dbh:split_range(nil, nil, 2), {})
+    for i = 1, 1000 do
+        assert(dbh:put(i * 10, 'value'))
+    end
+    splits = assert(dbh:split_range(nil, nil, 2))
+    assert.equal(#splits, 1)
+    assert.is_true(splits[1] > 3000 and splits[1] < 7000)
+
+    -- test that n is capped by the number of items in the range
+    splits = assert(dbh:split_range(10, 60, 2 ^ 40))
+    assert.is_true(#splits < 5)
+
+    -- test that throws an error if n is less than 1
+    local err = assert.throws(dbh.split_range, dbh, nil, nil, 0)
+    assert.match(err, 'n must be greater than 0')
+end
+
 function testcase.sequence()
     local dbh = opendbh()
 
@@ -0,0 +1,120 @@
+local testcase = require('testcase')
+local libmdbx = require('libmdbx')
+
+local PATHNAME = './test.db'
+local LOCKFILE = PATHNAME .. libmdbx.LOCK_SUFFIX
+
+function testcase.before_each()
+    os.remove(PATHNAME)
+    os.remove(LOCKFILE)
+end
+
+function testcase.after_each()
+    os.remove(PATHNAME)
+    os.remove(LOCKFILE)
+end
+
+local function opendbi(...)
+    local env = assert(libmdbx.new())
+    assert(env:open(PATHNAME, nil, libmdbx.NOSUBDIR, libmdbx.COALESCE,
+                    libmdbx.LIFORECLAIM))
+    local txn = assert(env:begin())
+    local dbi = assert(txn:dbi_open(...))
+    assert(txn:commit())
+    return dbi, env
+end
+
+local function sequence(env, dbi)
+    local txn = assert(env:begin(libmdbx.TXN_RDONLY))
+    local dbh = assert(dbi:dbh_open(txn))
+    local seq = assert(dbh:sequence())
+    txn:abort()
+    return seq
+end
+
+function testcase.next()
+    local dbi, env = opendbi()
+    local ia = assert(env:id_allocator(dbi, 10))
+    assert.match(ia, '^libmdbx.id_allocator: ', false)
+
+    -- test that hand out IDs from the reserved block
+    for i = 0, 9 do
+        assert.equal(ia:next(), i)
+    end
+    assert.equal(sequence(env, dbi), 10)
+    assert.equal(ia:remaining(), 0)
+
+    -- test that reserve the next block when the block is exhausted
+    assert.equal(ia:next(), 10)
+    assert.equal(ia:remaining(), 9)
+    assert.equal(sequence(env, dbi), 20)
+
+    -- test that allocators never hand out the same ID
+    local ia2 = assert(env:id_allocator(dbi, 10))
+    assert.equal(ia2:next(), 20)
+    assert.equal(ia:next(), 11)
+    assert.equal(ia:stat(), {
+        block = 10,
+        remaining = 8,
+        refills = 2,
+    })
+
+    -- test that throws an error if block is less than 1
+    local err = assert.throws(env.id_allocator, env, dbi, 0)
+    assert.match(err, 'block must be greater than 0')
+end
+
+function testcase.refill()
+    local dbi, env = opendbi()
+    local ia = assert(env:id_allocator(dbi, 2))
+
+    -- test that prefetch the next block
+    assert.equal(ia:next(), 0)
+    assert.is_true(ia:refill())
+    assert.equal(ia:remaining(), 3)
+    assert.equal(sequence(env, dbi), 4)
+
+    -- test that do nothing if the next block is already prefetched
+    assert.is_true(ia:refill())
+    assert.equal(sequence(env, dbi), 4)
+
+    -- test that switch to the prefetched block without write transaction
+    local txn = assert(env:begin())
+    assert.equal(ia:next(), 1)
+    assert.equal(ia:next(), 2)
+    assert.equal(ia:next(), 3)
+
+    -- test that return BUSY error if the thread has a write transaction
+    local id, err = ia:next()
+    assert.is_nil(id)
+    assert.equal(err, libmdbx.errno.BUSY)
+    local ok
+    ok, err = ia:refill()
+    assert.is_false(ok)
+    assert.equal(err, libmdbx.errno.BUSY)
+
+    -- test that take an ID from the sequence in the write transaction
+    assert.equal(ia:next(txn), 4)
+    assert.equal(ia:next(txn), 5)
+    assert.equal(ia:stat().refills, 2)
+
+    -- test that the IDs taken in the aborted transaction are rolled back
+    txn:abort()
+    assert.equal(ia:next(), 4)
+end
+
+function testcase.closed_env()
+    local dbi, env = opendbi()
+    local ia = assert(env:id_allocator(dbi, 1))
+    assert.equal(ia:next(), 0)
+
+    -- test that return EINVAL error after the env is closed
+    assert(env:close())
+    local id, err = ia:next()
+    assert.is_nil(id)
+    assert.equal(err, libmdbx.errno.EINVAL)
+    local ok
+    ok, err = ia:refill()
+    assert.is_false(ok)
+    assert.equal(err, libmdbx.errno.EINVAL)
+end
@@ -0,0 +1,207 @@
+local testcase = require('testcase')
+local fileno = require('io.fileno')
+local libmdbx = require('libmdbx')
+
+local PATHNAME = './test.db'
+local LOCKFILE = PATHNAME .. libmdbx.LOCK_SUFFIX
+
+function testcase.before_each()
+    os.remove(PATHNAME)
+    os.remove(LOCKFILE)
+end
+
+function testcase.after_each()
+    os.remove(PATHNAME)
+    os.remove(LOCKFILE)
+end
+
+local function openenv(...)
+    local env = assert(libmdbx.new())
+    assert(env:open(PATHNAME, nil, libmdbx.NOSUBDIR, libmdbx.COALESCE,
+                    libmdbx.LIFORECLAIM, ...))
+    return env
+end
+
+local function opendbi(...)
+    local env = openenv()
+    local txn = assert(env:begin())
+    local dbi = assert(txn:dbi_open(...))
+    assert(txn:commit())
+    return dbi, env
+end
+
+local function keyiter(n)
+    local i = 0
+    return function()
+        i = i + 1
+        if i <= n then
+            return string.format('key%08d', i), string.format('val%08d', i)
+        end
+    end
+end
+
+function testcase.load()
+    local dbi, env = opendbi()
+    local stats = {}
+    local loader = assert(env:bulk_loader(dbi, {
+        threshold = 1,
+        progress = function(stat)
+            stats[#stats + 1] = stat
+        end,
+    }))
+    assert.match(loader, '^libmdbx.loader: ', false)
+
+    -- test that load sorted pairs returned by iterator
+    assert.equal(loader:load(keyiter(1000)), 1000)
+    local stat = assert(loader:finish())
+    assert.equal(stat.count, 1000)
+    assert.equal(stat.bytes, 1000 * 22)
+    assert.greater(stat.commits, 1)
+    assert.equal(#stats, stat.commits)
+    assert.equal(stats[#stats].count, 1000)
+
+    -- confirm
+    local txn = assert(env:begin(libmdbx.TXN_RDONLY))
+    local dbh = assert(dbi:dbh_open(txn))
+    assert.equal(dbh:stat().entries, 1000)
+    assert.equal(dbh:get('key00000500'), 'val00000500')
+end
+
+function testcase.load_unsorted()
+    local dbi, env = opendbi()
+    local loader = assert(env:bulk_loader(dbi))
+    local list = {
+        'foo',
+        'bar',
+    }
+    local i = 0
+
+    -- test that return an error if pairs are not sorted in append mode
+    local n, err = loader:load(function()
+        i = i + 1
+        if list[i] then
+            return list[i], list[i] .. '-value'
+        end
+    end)
+    assert.is_nil(n)
+    assert.equal(err, libmdbx.errno.EKEYMISMATCH)
+    assert.equal(loader:stat().count, 0)
+
+    -- test that load unsorted pairs if append mode is disabled
+    loader = assert(env:bulk_loader(dbi, {
+        append = false,
+    }))
+    i = 0
+    assert.equal(loader:load(function()
+        i = i + 1
+        if list[i] then
+            return list[i], list[i] .. '-value'
+        end
+    end), 2)
+    assert.equal(loader:finish().count, 2)
+end
+
+function testcase.abort()
+    local dbi, env = opendbi()
+    local loader = assert(env:bulk_loader(dbi))
+
+    -- test that discard the uncommitted pairs
+    assert.equal(loader:load(keyiter(10)), 10)
+    loader:abort()
+    assert.equal(loader:stat().count, 0)
+    local txn = assert(env:begin(libmdbx.TXN_RDONLY))
+    local dbh = assert(dbi:dbh_open(txn))
+    assert.equal(dbh:stat().entries, 0)
+end
+
+function testcase.load_fd()
+    local dbi, env = opendbi()
+    local loader = assert(env:bulk_loader(dbi))
+    local pathname = './records.bin'
+    local function le32(n)
+        return string.char(n % 256, math.floor(n / 256) % 256,
+                           math.floor(n / 65536) % 256,
+                           math.floor(n / 16777216) % 256)
+    end
+    local function loadfile(data)
+        local f = assert(io.open(pathname, 'w+'))
+        f:write(data)
+        f:seek('set')
+        local n, err = loader:load(assert.is_int(fileno(f)))
+        f:close()
+        os.remove(pathname)
+        return n, err
+    end
+
+    -- test that load the length-prefixed records
+    assert.equal(loadfile(le32(3) .. 'foo' .. le32(9) .. 'foo-value' ..
+                              le32(3) .. 'qux' .. le32(0)), 2)
+    assert.equal(loader:finish().count, 2)
+
+    -- test that return EINVAL error if the record is truncated
+    local n, err = loadfile(le32(3) .. 'qu')
+    assert.is_nil(n)
+    assert.equal(err, libmdbx.errno.EINVAL)
+
+    -- test that return EINVAL error if the lengths exceed the limits
+    n, err = loadfile(le32(0xFFFFFFFF))
+    assert.is_nil(n)
+    assert.equal(err, libmdbx.errno.EINVAL)
+    n, err = loadfile(le32(3) .. 'qux' .. le32(0xFFFFFFFF))
+    assert.is_nil(n)
+    assert.equal(err, libmdbx.errno.EINVAL)
+end
+
+function testcase.callback_error()
+    local dbi, env = opendbi()
+    local loader = assert(env:bulk_loader(dbi))
+    local iter = keyiter(10)
+
+    -- test that abort the pending transaction if the iterator throws an error
+    local err = assert.throws(loader.load, loader, function()
+        local k, v = iter()
+        if not k then
+            error('iterator error')
+        end
+        return k, v
+    end)
+    assert.match(err, 'iterator error')
+    assert.equal(loader:stat().count, 0)
+    assert(env:begin()):abort()
+
+    -- test that rethrow the error of the progress callback
+    loader = assert(env:bulk_loader(dbi, {
+        threshold = 1,
+        progress = function()
+            error('progress error')
+        end,
+    }))
+    err = assert.throws(loader.load, loader, keyiter(1000))
+    assert.match(err, 'progress error')
+    assert(env:begin()):abort()
+end
+
+function testcase.closed_env()
+    local dbi, env = opendbi()
+    local loader = assert(env:bulk_loader(dbi))
+
+    -- test that return EINVAL error after the env is closed
+    assert(env:close())
+    local n, err = loader:load(keyiter(1))
+    assert.is_nil(n)
+    assert.equal(err, libmdbx.errno.EINVAL)
+end
+
+function testcase.invalid_options()
+    local dbi, env = opendbi()
+
+    -- test that throws an error if invalid options
+    local err = assert.throws(env.bulk_loader, env, dbi, {
+        progress = 'foo',
+    })
+    assert.match(err, 'field \'progress\' must be function')
+    err = assert.throws(env.bulk_loader, env, dbi, {
+        threshold = 0,
+    })
+    assert.match(err, 'field \'threshold\' must be greater than 0')
+end
@@ -0,0 +1,74 @@
+local testcase = require('testcase')
+local libmdbx = require('libmdbx')
+local msgpack = libmdbx.msgpack
+
+function testcase.encode_decode()
+    -- test that encode values and decode them
+    for _, v in ipairs({
+        true,
+        false,
+        0,
+        127,
+        128,
+        65536,
+        -1,
+        -33,
+        -129,
+        -40000,
+        -3000000000,
+        1.5,
+        'foo',
+        string.rep('x', 300),
+        string.rep('y', 70000),
+        {},
+        {
+            1,
+            'two',
+            {
+                3,
+            },
+        },
+        {
+            foo = 'bar',
+            baz = {
+                qux = true,
+            },
+            [1.5] = 'float key',
+        },
+        {
+            1,
+            nil,
+            3,
+            x = 5,
+        },
+    }) do
+        assert.equal(msgpack.decode(msgpack.encode(v)), v)
+    end
+    assert.is_nil(msgpack.decode(msgpack.encode(nil)))
+
+    -- test that encode to the MessagePack format
+    assert.equal(msgpack.encode(1), '\1')
+    assert.equal(msgpack.encode(-1), '\255')
+    assert.equal(msgpack.encode('a'), '\161a')
+    assert.equal(msgpack.encode({
+        1,
+    }), '\145\1')
+
+    -- test that throws an error if value type is not supported
+    local err = assert.throws(msgpack.encode, {
+        print,
+    })
+    assert.match(err, 'unsupported value type: function')
+
+    -- test that throws an error if table nesting is too deep
+    local v = {}
+    v[1] = v
+    err = assert.throws(msgpack.encode, v)
+    assert.match(err, 'nesting too deep')
+
+    -- test that throws an error if data is malformed
+    err = assert.throws(msgpack.decode, '\146\1')
+    assert.match(err, 'invalid msgpack encoding')
+    err = assert.throws(msgpack.decode, '\1\1')
+    assert.match(err, 'invalid msgpack encoding')
+end
@@ -0,0 +1,141 @@
+local testcase = require('testcase')
+local libmdbx = require('libmdbx')
+
+local FIELDS = {
+    {
+        'id',
+        'u32',
+    },
+    {
+        'delta',
+        'i16',
+    },
+    {
+        'score',
+        'f64',
+    },
+    {
+        'active',
+        'bool',
+    },
+    {
+        'name',
+        's8',
+    },
+}
+
+function testcase.new()
+    -- test that create a schema
+    local s = assert(libmdbx.schema(FIELDS))
+    assert.match(s, '^libmdbx.schema: ', false)
+    assert.equal(s:size(), 4 + 2 + 8 + 1 + 8)
+
+    -- test that throws an error if type is invalid
+    for _, v in ipairs({
+        'i7',
+        'f16',
+        's0',
+        'x8',
+        'u',
+    }) do
+        local err = assert.throws(libmdbx.schema, {
+            {
+                'foo',
+                v,
+            },
+        })
+        assert.match(err, 'field#1 type must be valid type string')
+    end
+
+    -- test that throws an error if name is duplicated
+    local err = assert.throws(libmdbx.schema, {
+        {
+            'foo',
+            'i8',
+        },
+        {
+            'foo',
+            'i8',
+        },
+    })
+    assert.match(err, 'field#2 name foo is duplicated')
+end
+
+function testcase.pack_unpack()
+    local s = assert(libmdbx.schema(FIELDS))
+
+    -- test that pack a table into a record and unpack it
+    local rec = s:pack({
+        id = 4000000000,
+        delta = -2,
+        score = 1.5,
+        active = true,
+        name = 'foo',
+    })
+    assert.equal(#rec, s:size())
+    assert.equal(s:unpack(rec), {
+        id = 4000000000,
+        delta = -2,
+        score = 1.5,
+        active = true,
+        name = 'foo',
+    })
+
+    -- test that missing fields are filled with zero
+    assert.equal(s:unpack(s:pack({})), {
+        id = 0,
+        delta = 0,
+        score = 0,
+        active = false,
+        name = '',
+    })
+
+    -- test that get a field by name or index
+    assert.equal(s:get(rec, 'delta'), -2)
+    assert.equal(s:get(rec, 5), 'foo')
+
+    -- test that throws an error if field value is invalid
+    local err = assert.throws(s.pack, s, {
+        id = 1.5,
+    })
+    assert.match(err, 'field id must be integer, got number')
+    err = assert.throws(s.pack, s, {
+        name = 'too long name',
+    })
+    assert.match(err, 'string length must be less than or equal to 8')
+
+    -- test that throws an error if integer value is out of range of field
+    err = assert.throws(s.pack, s, {
+        id = -1,
+    })
+    assert.match(err, 'field id is out of range')
+    err = assert.throws(s.pack, s, {
+        id = 4294967296,
+    })
+    assert.match(err, 'field id is out of range')
+    err = assert.throws(s.pack, s, {
+        delta = 32768,
+    })
+    assert.match(err, 'field delta is out of range')
+    assert.equal(s:unpack(s:pack({
+        delta = -32768,
+    })).delta, -32768)
+
+    -- test that the unsigned 64-bit field stores the negative integer as
+    -- the two's complement and returns it as is
+    local s64 = assert(libmdbx.schema({
+        {
+            'big',
+            'u64',
+        },
+    }))
+    assert.equal(s64:unpack(s64:pack({
+        big = -1,
+    })), {
+        big = -1,
+    })
+
+    -- test that throws an error if field does not exist
+    err = assert.throws(s.get, s, rec, 'unknown')
+    assert.match(err, 'unknown field: unknown')
+end
@@ -0,0 +1,132 @@
+local unpack = unpack or table.unpack
+local testcase = require('testcase')
+local libmdbx = require('libmdbx')
+local tuple = libmdbx.tuple
+
+function testcase.pack_unpack()
+    -- test that pack values and unpack them
+    for _, v in ipairs({
+        {},
+        {
+            'foo',
+            1,
+            true,
+        },
+        {
+            -1,
+            0,
+            255,
+            256,
+            -256,
+            math.maxinteger or 2 ^ 53,
+            math.mininteger or -2 ^ 53,
+        },
+        {
+            1.5,
+            -0.25,
+            false,
+        },
+        {
+            'foo\0bar',
+            '',
+            '\0',
+        },
+    }) do
+        assert.equal({
+            tuple.unpack(tuple.pack(unpack(v))),
+        }, v)
+    end
+
+    -- test that nil is encoded
+    local a, b, c = tuple.unpack(tuple.pack('foo', nil, 1))
+    assert.equal(a, 'foo')
+    assert.is_nil(b)
+    assert.equal(c, 1)
+
+    -- test that throws an error if value type is not supported
+    local err = assert.throws(tuple.pack, 'foo', {})
+    assert.match(err, 'unsupported value type: table')
+
+    -- test that throws an error if encoding is invalid
+    err = assert.throws(tuple.unpack, '\2foo')
+    assert.match(err, 'invalid tuple encoding')
+end
+
+function testcase.order()
+    -- test that encoded tuples are sorted in the order of values
+    for _, v in ipairs({
+        {
+            {
+                -257,
+            },
+            {
+                -256,
+            },
+            {
+                -1,
+            },
+            {
+                0,
+            },
+            {
+                1,
+            },
+            {
+                256,
+            },
+        },
+        {
+            {
+                -1.5,
+            },
+            {
+                -0.5,
+            },
+            {
+                0.5,
+            },
+            {
+                1.5,
+            },
+        },
+        {
+            {
+                'a',
+            },
+            {
+                'a',
+                1,
+            },
+            {
+                'a\0',
+            },
+            {
+                'ab',
+            },
+        },
+    }) do
+        for i = 2, #v do
+            local a = tuple.pack(unpack(v[i - 1]))
+            local b = tuple.pack(unpack(v[i]))
+            assert.is_true(a < b)
+        end
+    end
+end
+
+function testcase.range()
+    -- test that returns the range of the tuples that start with values
+    local start, stop = tuple.range('foo', 1)
+    assert.equal(start, tuple.pack('foo', 1))
+    assert.is_true(tuple.pack('foo', 1, 'bar') < stop)
+    assert.is_true(tuple.pack('foo', 1, 'bar') > start)
+    assert.is_true(tuple.pack('foo', 2) > stop)
+
+    -- test that the range excludes the strings that have the embedded null
+    -- byte after the prefix
+    start, stop = tuple.range('foo')
+    assert.equal(stop, tuple.pack('foo') .. '\255')
+    assert.is_true(tuple.pack('foo', 1) < stop)
+    assert.is_true(tuple.pack('foo', 'bar') < stop)
+    assert.is_true(tuple.pack('foo\0bar') > stop)
+    assert.is_true(tuple.pack('foo\0') > stop)
+end
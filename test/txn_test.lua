@@ -187,6 +187,163 @@ function testcase.dbi_open()
     assert.equal(txn:dbi_open('bar'), dbi2)
 end
 
+function testcase.dbi_open_with_comparator()
+    local txn = assert(opentxn())
+    local function collect(dbh)
+        local keys = {}
+        for k in dbh:range() do
+            keys[#keys + 1] = k
+        end
+        return keys
+    end
+
+    -- test that keys are sorted by the int64 comparator
+    local dbi = assert(txn:dbi_open('int64', libmdbx.CREATE, {
+        keycmp = 'int64',
+    }))
+    local dbh = assert(dbi:dbh_open(txn))
+    for _, k in ipairs({
+        10,
+        -1,
+        0,
+        -100,
+    }) do
+        assert(dbh:put(k, 'value'))
+    end
+    assert.equal(collect(dbh), {
+        -100,
+        -1,
+        0,
+        10,
+    })
+
+    -- test that the dbi that is already open keeps the integer conversion
+    assert.equal(assert(txn:dbi_open('int64')), dbi)
+    assert.equal(assert(txn:dbi_open('int64', {
+        keycmp = 'int64',
+    })), dbi)
+
+    -- test that return INCOMPATIBLE error if the comparator requires the
+    -- integer conversion that the dbi that is already open does not have
+    local plain = assert(txn:dbi_open('plain', libmdbx.CREATE))
+    local v, err = txn:dbi_open('plain', {
+        keycmp = 'int64',
+    })
+    assert.is_nil(v)
+    assert.equal(err, libmdbx.errno.INCOMPATIBLE)
+    assert(assert(plain:dbh_open(txn)):put('foo', 'bar'))
+
+    -- test that keys are sorted by the icase comparator
+    dbi = assert(txn:dbi_open('icase', libmdbx.CREATE, {
+        keycmp = 'icase',
+    }))
+    dbh = assert(dbi:dbh_open(txn))
+    assert(dbh:put('b', 'value'))
+    assert(dbh:put('A', 'value'))
+    assert(dbh:put('C', 'value'))
+    assert.equal(dbh:get('a'), 'value')
+    assert.equal(collect(dbh), {
+        'A',
+        'b',
+        'C',
+    })
+
+    -- test that non-ASCII bytes are not folded by the icase comparator
+    assert(dbh:put('\196', 'upper'))
+    assert(dbh:put('\228', 'lower'))
+    assert.equal(dbh:get('\196'), 'upper')
+    assert.equal(dbh:get('\228'), 'lower')
+
+    -- test that keys are sorted by the double comparator in the total order
+    local s = assert(libmdbx.schema({
+        {
+            'v',
+            'f64',
+        },
+    }))
+    local function double(v)
+        return s:pack({
+            v = v,
+        })
+    end
+    dbi = assert(txn:dbi_open('double', libmdbx.CREATE, {
+        keycmp = 'double',
+    }))
+    dbh = assert(dbi:dbh_open(txn))
+    for _, v in ipairs({
+        1.5,
+        -2,
+        math.huge,
+        0 / 0,
+        -math.huge,
+    }) do
+        assert(dbh:put(double(v), tostring(v)))
+    end
+    assert.equal(dbh:stat().entries, 5)
+    assert.equal(dbh:get(double(0 / 0)), tostring(0 / 0))
+    local nums = {}
+    for _, k in ipairs(collect(dbh)) do
+        local v = s:get(k, 'v')
+        if v == v then
+            nums[#nums + 1] = v
+        end
+    end
+    assert.equal(nums, {
+        -math.huge,
+        -2,
+        1.5,
+        math.huge,
+    })
+
+    -- test that values are sorted by the reverse comparator
+    dbi = assert(txn:dbi_open('reverse', libmdbx.CREATE, libmdbx.DUPSORT, {
+        datacmp = 'reverse',
+    }))
+    dbh = assert(dbi:dbh_open(txn))
+    assert(dbh:put('foo', 'a'))
+    assert(dbh:put('foo', 'c'))
+    assert(dbh:put('foo', 'b'))
+    local vals = {}
+    for _, v in dbh:range() do
+        vals[#vals + 1] = v
+    end
+    assert.equal(vals, {
+        'c',
+        'b',
+        'a',
+    })
+
+    -- test that throws an error if comparator is unknown
+    err = assert.throws(txn.dbi_open, txn, 'foo', libmdbx.CREATE, {
+        keycmp = 'unknown',
+    })
+    assert.match(err, 'unknown keycmp comparator: unknown')
+end
+
+function testcase.dbi_open_with_compress()
+    local txn = assert(opentxn())
+
+    -- test that open a database that compresses values
+    local dbi = assert(txn:dbi_open('foo', libmdbx.CREATE, {
+        compress = 64,
+    }))
+    local dbh = assert(dbi:dbh_open(txn))
+    assert(dbh:put('foo', string.rep('a', 1024)))
+    assert.equal(dbh:get('foo'), string.rep('a', 1024))
+
+    -- test that return INCOMPATIBLE error for the dupsort database
+    local _, err = txn:dbi_open('dup', libmdbx.CREATE, libmdbx.DUPSORT, {
+        compress = 64,
+    })
+    assert.equal(err, libmdbx.errno.INCOMPATIBLE)
+
+    -- test that throws an error if compress is negative
+    err = assert.throws(txn.dbi_open, txn, 'foo', libmdbx.CREATE, {
+        compress = -1,
+    })
+    assert.match(err, "field 'compress' must be greater than or equal to 0")
+end
+
 function testcase.is_dirty()
     -- TODO: Determines whether the given address is on a dirty database page
     -- of the transaction or not
@@ -0,0 +1,167 @@
+local testcase = require('testcase')
+local libmdbx = require('libmdbx')
+
+local PATHNAME = './test.db'
+local LOCKFILE = PATHNAME .. libmdbx.LOCK_SUFFIX
+
+function testcase.before_each()
+    os.remove(PATHNAME)
+    os.remove(LOCKFILE)
+end
+
+function testcase.after_each()
+    os.remove(PATHNAME)
+    os.remove(LOCKFILE)
+end
+
+local function openenv(...)
+    local env = assert(libmdbx.new())
+    assert(env:open(PATHNAME, nil, libmdbx.NOSUBDIR, libmdbx.COALESCE,
+                    libmdbx.LIFORECLAIM, ...))
+    return env
+end
+
+local function opendbh(...)
+    local env = openenv()
+    local txn = assert(env:begin())
+    local dbi = assert(txn:dbi_open(...))
+    local dbh = assert(dbi:dbh_open(txn))
+    assert(dbh:put('hello', 'world'))
+    assert(txn:commit())
+
+    txn = assert(env:begin(libmdbx.TXN_RDONLY))
+    dbh = assert(dbi:dbh_open(txn))
+    dbh:viewmode(true)
+    return dbh, txn
+end
+
+function testcase.len()
+    local dbh = opendbh()
+    local v = assert(dbh:get('hello'))
+
+    -- test that return the length of value
+    assert.match(tostring(v), 'world')
+    assert.equal(v:len(), 5)
+    assert.equal(#v, 5)
+end
+
+function testcase.tostring()
+    local dbh = opendbh()
+    local v = assert(dbh:get('hello'))
+
+    -- test that return a copy of value as string
+    assert.equal(v:tostring(), 'world')
+    assert.equal(tostring(v), 'world')
+end
+
+function testcase.sub()
+    local dbh = opendbh()
+    local v = assert(dbh:get('hello'))
+
+    -- test that return a view of the substring
+    local sv = assert(v:sub(2, 4))
+    assert.equal(sv:tostring(), 'orl')
+    assert.equal(v:sub(-3):tostring(), 'rld')
+    assert.equal(v:sub(4, 2):tostring(), '')
+end
+
+function testcase.byte()
+    local dbh = opendbh()
+    local v = assert(dbh:get('hello'))
+
+    -- test that return the internal numeric codes of the characters
+    assert.equal({
+        v:byte(),
+    }, {
+        string.byte('w'),
+    })
+    assert.equal({
+        v:byte(1, -1),
+    }, {
+        string.byte('world', 1, -1),
+    })
+    assert.equal({
+        v:byte(10),
+    }, {})
+end
+
+function testcase.compare()
+    local dbh = opendbh()
+    local v = assert(dbh:get('hello'))
+
+    -- test that compare with string or view
+    assert.equal(v:compare('world'), 0)
+    assert.equal(v:compare('worlds'), -1)
+    assert.equal(v:compare('abc'), 1)
+    assert.equal(v:compare(v:sub(1, 3)), 1)
+    assert.is_true(v == assert(dbh:get('hello')))
+    assert.is_true(v:sub(1, 3) < v)
+end
+
+function testcase.is_valid()
+    local dbh, txn = opendbh()
+    local v = assert(dbh:get('hello'))
+
+    -- test that view is valid until the transaction ends
+    assert.is_true(v:is_valid())
+    assert(txn:commit())
+    assert.is_false(v:is_valid())
+
+    -- test that throws an error if view is invalidated
+    local err = assert.throws(v.tostring, v)
+    assert.match(err, 'invalidated libmdbx.view')
+end
+
+local function reserve(size)
+    local env = openenv()
+    local txn = assert(env:begin())
+    local dbi = assert(txn:dbi_open())
+    local dbh = assert(dbi:dbh_open(txn))
+    dbh:viewmode(true)
+    return assert(dbh:reserve('foo', size)), dbh
+end
+
+function testcase.write()
+    local v, dbh = reserve(10)
+
+    -- test that write bytes into the reserved space
+    assert.is_true(v:is_writable())
+    assert.equal(v:write('hello'), 6)
+    assert.equal(v:write('world', 6), 11)
+    assert.equal(v:tostring(), 'helloworld')
+
+    -- test that write bytes of view
+    assert.equal(v:write(v:sub(6, 10)), 6)
+    assert.equal(v:tostring(), 'worldworld')
+    assert.equal(dbh:get('foo'):tostring(), 'worldworld')
+
+    -- test that throws an error if out of range
+    local err = assert.throws(v.write, v, 'foo', 9)
+    assert.match(err, 'out of range')
+
+    -- test that throws an error if view is read-only
+    local rv = assert(dbh:get('foo'))
+    assert.is_false(rv:is_writable())
+    err = assert.throws(rv.write, rv, 'foo')
+    assert.match(err, 'attempt to write to a read-only libmdbx.view')
+
+    -- test that reserved space is invalidated by the next update
+    assert(dbh:put('bar', 'baz'))
+    err = assert.throws(v.write, v, 'foo')
+    assert.match(err, 'invalidated libmdbx.view')
+end
+
+function testcase.write_int()
+    local v = reserve(15)
+
+    -- test that write integers in native byte order
+    assert.equal(v:write_int(0x01010101, 4), 5)
+    assert.equal(v:write_int(0x0202, 2, 5), 7)
+    assert.equal(v:write_int(3, 1, 7), 8)
+    assert.equal(v:write_int(0x0404040404040404, nil, 8), 16)
+    assert.equal(v:tostring(), '\1\1\1\1\2\2\3\4\4\4\4\4\4\4\4')
+
+    -- test that throws an error if invalid size
+    local err = assert.throws(v.write_int, v, 1, 3)
+    assert.match(err, 'size must be 1, 2, 4 or 8')
+end